@@ -0,0 +1,444 @@
+// Renderer benchmarks. Every scenario runs headless with a fixed timestep and
+// a fixed random seed, so two runs of the same build render identical frames.
+//
+//   obsidian_bench [--frames N] [--warmup N] [--size WxH] [--scenario NAME]...
+//                  [--font FILE.ttf] [--format json|csv] [--out FILE] [--list]
+//
+// Text scenarios need --font and are skipped without it.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <sstream>
+
+#include "../obsidian_engine/core.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+struct Scene {
+    vector<shared_ptr<Shape>> shapes;
+    vector<glm::vec2> velocities;
+    vector<shared_ptr<LightSource>> lights;
+    size_t next = 0;  // Round-robin cursor for scenarios replacing shapes
+    int frame = 0;
+    string font;      // --font, for the text scenarios
+    mt19937 rng{ 1234 };
+
+    float random(float lo, float hi) {
+        return uniform_real_distribution<float>(lo, hi)(rng);
+    }
+};
+
+struct Scenario {
+    const char* name;
+    const char* description;
+    function<void(Graphics&, Scene&)> create;
+    function<void(Graphics&, Scene&, float)> update;  // Called before every render() with the timestep
+    bool needsFont = false;
+};
+
+struct Result {
+    string name;
+    int frames = 0;
+    double cpuMean = 0, cpuP50 = 0, cpuP90 = 0, cpuP99 = 0, cpuMax = 0;
+    double gpuMean = 0, gpuP50 = 0, gpuP99 = 0;
+    double drawCalls = 0, stateChanges = 0, vertices = 0, uploadedBytes = 0;
+    long rssKb = 0;      // Resident set with the scenario still loaded
+    long peakRssKb = 0;  // High-water mark of the whole process, so far
+};
+
+struct Options {
+    int frames = 600;
+    int warmup = 60;
+    int width = 1280;
+    int height = 720;
+    vector<string> scenarios;
+    string format = "json";
+    string out;
+    string font;
+};
+
+glm::vec2 halfExtent(const Graphics& graphics) {
+    AABB view = graphics.getViewBounds();
+    return (view.max - view.min) * 0.5f;
+}
+
+// Random small rectangles filling the screen
+void spawnSprites(Graphics& graphics, Scene& scene, size_t count, bool moving) {
+    glm::vec2 half = halfExtent(graphics);
+    for (size_t i = 0; i < count; ++i) {
+        auto sprite = Shape::createRectangle(scene.random(2.0f, 8.0f), scene.random(2.0f, 8.0f));
+        sprite->setPosition({ scene.random(-half.x, half.x), scene.random(-half.y, half.y) });
+        sprite->tint = glm::vec4(scene.random(0.2f, 1.0f), scene.random(0.2f, 1.0f), scene.random(0.2f, 1.0f), 1.0f);
+        graphics.addShape(sprite);
+        scene.shapes.push_back(sprite);
+        if (moving) scene.velocities.emplace_back(scene.random(-80.0f, 80.0f), scene.random(-80.0f, 80.0f));
+    }
+}
+
+void moveSprites(Graphics& graphics, Scene& scene, float dt) {
+    glm::vec2 half = halfExtent(graphics);
+    for (size_t i = 0; i < scene.shapes.size(); ++i) {
+        glm::vec2 position = scene.shapes[i]->getPosition() + scene.velocities[i] * dt;
+        // Bounce off the screen edges
+        if (position.x < -half.x || position.x > half.x) scene.velocities[i].x = -scene.velocities[i].x;
+        if (position.y < -half.y || position.y > half.y) scene.velocities[i].y = -scene.velocities[i].y;
+        scene.shapes[i]->setPosition(position);
+    }
+}
+
+void addAmbient(Graphics& graphics, float intensity) {
+    auto ambient = make_shared<LightSource>(LightType::Ambient, glm::vec2(0.0f));
+    ambient->intensity = intensity;
+    graphics.addLight(ambient);
+}
+
+Scenario lightsScenario(const char* name, const char* description, LightingMode mode) {
+    return {
+        name, description,
+        [mode](Graphics& g, Scene& s) {
+            g.setLightingMode(mode);
+            addAmbient(g, 0.1f);
+            spawnSprites(g, s, 2000, false);
+            glm::vec2 half = halfExtent(g);
+            for (int i = 0; i < 256; ++i) {
+                auto light = make_shared<LightSource>(LightType::Point,
+                    glm::vec2(s.random(-half.x, half.x), s.random(-half.y, half.y)));
+                light->radius = s.random(40.0f, 160.0f);
+                light->color = glm::vec3(s.random(0.3f, 1.0f), s.random(0.3f, 1.0f), s.random(0.3f, 1.0f));
+                g.addLight(light);
+                s.lights.push_back(light);
+                s.velocities.emplace_back(s.random(-60.0f, 60.0f), s.random(-60.0f, 60.0f));
+            }
+        },
+        [](Graphics& g, Scene& s, float dt) {
+            glm::vec2 half = halfExtent(g);
+            for (size_t i = 0; i < s.lights.size(); ++i) {
+                glm::vec2& position = s.lights[i]->position;
+                position += s.velocities[i] * dt;
+                if (position.x < -half.x || position.x > half.x) s.velocities[i].x = -s.velocities[i].x;
+                if (position.y < -half.y || position.y > half.y) s.velocities[i].y = -s.velocities[i].y;
+            }
+        }
+    };
+}
+
+vector<Scenario> scenarios() {
+    return {
+        { "static_sprites_10k", "10k static batched sprites",
+          [](Graphics& g, Scene& s) { addAmbient(g, 1.0f); spawnSprites(g, s, 10000, false); },
+          nullptr },
+        { "static_sprites_100k", "100k static batched sprites",
+          [](Graphics& g, Scene& s) { addAmbient(g, 1.0f); spawnSprites(g, s, 100000, false); },
+          nullptr },
+        { "moving_sprites_10k", "10k sprites bouncing around the screen",
+          [](Graphics& g, Scene& s) { addAmbient(g, 1.0f); spawnSprites(g, s, 10000, true); },
+          [](Graphics& g, Scene& s, float dt) { moveSprites(g, s, dt); } },
+        lightsScenario("lights_forward", "256 moving point lights over 2k sprites, forward shading", LightingMode::Forward),
+        lightsScenario("lights_deferred", "256 moving point lights over 2k sprites, deferred shading", LightingMode::Deferred),
+        lightsScenario("lights_tiled", "256 moving point lights over 2k sprites, tiled forward shading", LightingMode::Tiled),
+        { "texture_churn", "16 new 64x64 textures per frame on 256 sprites",
+          [](Graphics& g, Scene& s) { addAmbient(g, 1.0f); spawnSprites(g, s, 256, false); },
+          [](Graphics&, Scene& s, float) {
+              vector<unsigned char> pixels(64 * 64 * 4);
+              for (int i = 0; i < 16; ++i) {
+                  // Unique content, so the registry cannot deduplicate the upload
+                  uint32_t seed = s.rng();
+                  for (size_t p = 0; p < pixels.size(); ++p) pixels[p] = static_cast<unsigned char>(seed >> (p % 4 * 8)) ^ static_cast<unsigned char>(p);
+                  s.shapes[s.next]->setTexture(Texture::fromPixels(64, 64, pixels.data()));
+                  s.next = (s.next + 1) % s.shapes.size();
+              }
+          } },
+        { "spawn_despawn", "500 sprites added and 500 removed per frame, 5k alive",
+          [](Graphics& g, Scene& s) { addAmbient(g, 1.0f); spawnSprites(g, s, 5000, false); },
+          [](Graphics& g, Scene& s, float) {
+              for (int i = 0; i < 500; ++i) {
+                  g.removeShape(s.shapes[s.next]);
+                  s.next = (s.next + 1) % s.shapes.size();
+              }
+              // Refill the freed slots with new shapes
+              size_t start = (s.next + s.shapes.size() - 500) % s.shapes.size();
+              glm::vec2 half = halfExtent(g);
+              for (int i = 0; i < 500; ++i) {
+                  auto& slot = s.shapes[(start + i) % s.shapes.size()];
+                  slot = Shape::createRectangle(s.random(2.0f, 8.0f), s.random(2.0f, 8.0f));
+                  slot->setPosition({ s.random(-half.x, half.x), s.random(-half.y, half.y) });
+                  g.addShape(slot);
+              }
+          } },
+        { "heavy_text", "2000 changing world-space labels and a 40 line screen overlay per frame",
+          [](Graphics& g, Scene& s) {
+              addAmbient(g, 1.0f);
+              g.loadFont(s.font, 24.0f);
+              glm::vec2 half = halfExtent(g);
+              for (int i = 0; i < 2000; ++i) {
+                  s.velocities.emplace_back(s.random(-half.x, half.x), s.random(-half.y, half.y));
+              }
+          },
+          [](Graphics& g, Scene& s, float) {
+              // Damage numbers: new values every frame, drifting upwards
+              for (size_t i = 0; i < s.velocities.size(); ++i) {
+                  int value = static_cast<int>((i * 7919 + s.frame * 31) % 100000);
+                  glm::vec2 position = s.velocities[i] + glm::vec2(0.0f, static_cast<float>((s.frame + i) % 60));
+                  g.renderText(to_string(value), position, 0.5f, glm::vec3(1.0f, 0.3f, 0.2f));
+              }
+              for (int line = 0; line < 40; ++line) {
+                  g.renderScreenText("frame " + to_string(s.frame) + "  entity " + to_string(line * 131 + s.frame % 97) +
+                                     "  \xC3\xA9tat: \xE2\x9C\x93 ok", glm::vec2(8.0f, 8.0f + line * 14.0f), 0.5f,
+                                     glm::vec3(0.8f));
+              }
+              s.frame++;
+          },
+          true },
+    };
+}
+
+long peakRssKb() {
+#ifndef _WIN32
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // Bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+long currentRssKb() {
+#ifdef __linux__
+    long pages = 0, resident = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) return 0;
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(statm);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+    return 0;
+#endif
+}
+
+double percentile(vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+    return values[min(index, values.size() - 1)];
+}
+
+double mean(const vector<double>& values) {
+    if (values.empty()) return 0.0;
+    return accumulate(values.begin(), values.end(), 0.0) / values.size();
+}
+
+class BenchApp : public Obsidian {
+public:
+    BenchApp(const Scenario& scenario, const Options& options)
+        : Obsidian(options.width, options.height, scenario.name), m_scenario(scenario), m_options(options) {
+        m_scene.font = options.font;
+    }
+
+    string renderer;
+
+protected:
+    void onCreate(Graphics& graphics) override {
+        const GLubyte* name = glGetString(GL_RENDERER);
+        renderer = name ? reinterpret_cast<const char*>(name) : "";
+
+        graphics.setRenderMode(RenderMode::Batched);
+        Profiler& profiler = graphics.getProfiler();
+        profiler.setHistorySize(static_cast<size_t>(m_options.frames));
+        profiler.setEnabled(true);
+
+        m_scenario.create(graphics, m_scene);
+    }
+
+    void onDraw(Graphics& graphics) override {
+        if (m_scenario.update) {
+            Profiler::CpuScope scope(graphics.getProfiler(), "update");
+            m_scenario.update(graphics, m_scene, m_timestep);
+        }
+        graphics.render();
+    }
+
+private:
+    const Scenario& m_scenario;
+    const Options& m_options;
+    Scene m_scene;
+    float m_timestep = 1.0f / 60.0f;
+};
+
+bool runScenario(const Scenario& scenario, const Options& options, Result& result, string& renderer) {
+    BenchApp app(scenario, options);
+
+    HeadlessOptions headless;
+    headless.frames = options.frames;
+    if (!app.runHeadless(headless)) return false;
+    renderer = app.renderer;
+
+    vector<double> cpu, gpu, drawCalls, stateChanges, vertices, uploaded;
+    for (const FrameProfile& frame : app.getGraphics()->getProfiler().history()) {
+        if (frame.frame <= static_cast<uint64_t>(options.warmup)) continue;
+        cpu.push_back(frame.cpuMs);
+        if (frame.gpuResolved) gpu.push_back(frame.gpuTotalMs());
+        drawCalls.push_back(frame.counters.drawCalls);
+        stateChanges.push_back(frame.counters.stateChanges);
+        vertices.push_back(frame.counters.vertices);
+        uploaded.push_back(static_cast<double>(frame.counters.uploadedBytes));
+    }
+
+    result.name = scenario.name;
+    result.frames = static_cast<int>(cpu.size());
+    result.cpuMean = mean(cpu);
+    result.cpuP50 = percentile(cpu, 0.50);
+    result.cpuP90 = percentile(cpu, 0.90);
+    result.cpuP99 = percentile(cpu, 0.99);
+    result.cpuMax = percentile(cpu, 1.0);
+    result.gpuMean = mean(gpu);
+    result.gpuP50 = percentile(gpu, 0.50);
+    result.gpuP99 = percentile(gpu, 0.99);
+    result.drawCalls = mean(drawCalls);
+    result.stateChanges = mean(stateChanges);
+    result.vertices = mean(vertices);
+    result.uploadedBytes = mean(uploaded);
+    result.rssKb = currentRssKb();
+    result.peakRssKb = peakRssKb();
+    return true;
+}
+
+string escape(const string& text) {
+    string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+void writeJson(ostream& out, const Options& options, const string& renderer, const vector<Result>& results) {
+    out << "{\n  \"renderer\": \"" << escape(renderer) << "\",\n"
+        << "  \"width\": " << options.width << ",\n  \"height\": " << options.height << ",\n"
+        << "  \"frames\": " << options.frames << ",\n  \"warmup\": " << options.warmup << ",\n"
+        << "  \"scenarios\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << (i ? ",\n" : "\n")
+            << "    {\"name\": \"" << r.name << "\", \"frames\": " << r.frames
+            << ", \"cpu_ms\": {\"mean\": " << r.cpuMean << ", \"p50\": " << r.cpuP50 << ", \"p90\": " << r.cpuP90
+            << ", \"p99\": " << r.cpuP99 << ", \"max\": " << r.cpuMax << "}"
+            << ", \"gpu_ms\": {\"mean\": " << r.gpuMean << ", \"p50\": " << r.gpuP50 << ", \"p99\": " << r.gpuP99 << "}"
+            << ", \"draw_calls\": " << r.drawCalls << ", \"state_changes\": " << r.stateChanges
+            << ", \"vertices\": " << r.vertices << ", \"uploaded_bytes\": " << r.uploadedBytes
+            << ", \"rss_kb\": " << r.rssKb << ", \"peak_rss_kb\": " << r.peakRssKb << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void writeCsv(ostream& out, const vector<Result>& results) {
+    out << "scenario,frames,cpu_mean_ms,cpu_p50_ms,cpu_p90_ms,cpu_p99_ms,cpu_max_ms,gpu_mean_ms,gpu_p50_ms,gpu_p99_ms,"
+           "draw_calls,state_changes,vertices,uploaded_bytes,rss_kb,peak_rss_kb\n";
+    for (const Result& r : results) {
+        out << r.name << ',' << r.frames << ',' << r.cpuMean << ',' << r.cpuP50 << ',' << r.cpuP90 << ','
+            << r.cpuP99 << ',' << r.cpuMax << ',' << r.gpuMean << ',' << r.gpuP50 << ',' << r.gpuP99 << ','
+            << r.drawCalls << ',' << r.stateChanges << ',' << r.vertices << ',' << r.uploadedBytes << ','
+            << r.rssKb << ',' << r.peakRssKb << '\n';
+    }
+}
+
+void usage() {
+    cerr << "usage: obsidian_bench [--frames N] [--warmup N] [--size WxH] [--scenario NAME]...\n"
+            "                      [--font FILE.ttf] [--format json|csv] [--out FILE] [--list]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    const vector<Scenario> all = scenarios();
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--list") {
+            for (const auto& scenario : all) cout << scenario.name << "\t" << scenario.description << "\n";
+            return 0;
+        } else if (arg == "--frames" && hasValue) {
+            options.frames = max(1, atoi(argv[++i]));
+        } else if (arg == "--warmup" && hasValue) {
+            options.warmup = max(0, atoi(argv[++i]));
+        } else if (arg == "--size" && hasValue) {
+            if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2) {
+                usage();
+                return 2;
+            }
+        } else if (arg == "--scenario" && hasValue) {
+            options.scenarios.push_back(argv[++i]);
+        } else if (arg == "--format" && hasValue) {
+            options.format = argv[++i];
+        } else if (arg == "--font" && hasValue) {
+            options.font = argv[++i];
+        } else if (arg == "--out" && hasValue) {
+            options.out = argv[++i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (options.format != "json" && options.format != "csv") {
+        usage();
+        return 2;
+    }
+    options.warmup = min(options.warmup, options.frames - 1);
+
+    vector<Result> results;
+    string renderer;
+    for (const auto& scenario : all) {
+        if (!options.scenarios.empty() &&
+            find(options.scenarios.begin(), options.scenarios.end(), scenario.name) == options.scenarios.end()) {
+            continue;
+        }
+        if (scenario.needsFont && options.font.empty()) {
+            cerr << "Skipping " << scenario.name << ", it needs --font" << endl;
+            continue;
+        }
+        cerr << "Running " << scenario.name << "..." << endl;
+
+        Result result;
+        if (!runScenario(scenario, options, result, renderer)) {
+            cerr << "Scenario failed: " << scenario.name << endl;
+            return 1;
+        }
+        results.push_back(result);
+    }
+    if (results.empty()) {
+        cerr << "No matching scenarios, see --list" << endl;
+        return 2;
+    }
+
+    ostringstream report;
+    if (options.format == "csv") writeCsv(report, results);
+    else writeJson(report, options, renderer, results);
+
+    if (options.out.empty()) {
+        cout << report.str();
+    } else {
+        ofstream file(options.out);
+        if (!file) {
+            cerr << "Failed to open output file: " << options.out << endl;
+            return 1;
+        }
+        file << report.str();
+    }
+    return 0;
+}
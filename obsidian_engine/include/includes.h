@@ -10,12 +10,28 @@
 #include "../third_party/glfw/include/GLFW/glfw3.h"
 #include "../third_party/stb/stb_image.h"
 #include "../third_party/stb/stb_truetype.h"
+#include "../third_party/stb/stb_image_write.h"
 
 // Engine includes
 #include "./obsidian.h"
 #include "./utils/Texture.h"
+#include "./utils/TextureRegistry.h"
+#include "./utils/TextureAtlas.h"
+#include "./utils/TextureLoader.h"
+#include "./utils/MeshRegistry.h"
+#include "./utils/StreamBuffer.h"
+#include "./utils/AABB.h"
+#include "./utils/SpatialGrid.h"
+#include "./utils/RenderQueue.h"
+#include "./utils/RenderCommandList.h"
+#include "./utils/SlotMap.h"
+#include "./utils/ShadowMap.h"
+#include "./utils/GBuffer.h"
+#include "./utils/LightGrid.h"
+#include "./utils/Profiler.h"
 #include "./utils/Vertex.h"
 #include "./utils/Font.h"
+#include "./utils/TextMesh.h"
 #include "./utils/Graphics.h"
 #include "./utils/Object.h"
 
@@ -3,11 +3,22 @@
 
 
 #include "./utils/Graphics.h"
+#include "./utils/RenderCommandList.h"
 #include "includes.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 
 typedef glm::vec4 Color;
 
+// Settings for Obsidian::runHeadless
+struct HeadlessOptions {
+    int frames = 300;                 // Frames to render before returning
+    float timestep = 1.0f / 60.0f;    // deltaTime passed to onFrameDrawn, independent of wall time
+    bool readback = false;            // Read every frame back and pass it to onFrameRead
+};
+
 class Obsidian {
 public:
     Obsidian(int width = 800, int height = 600, const char* title = "Obsidian Window");
@@ -20,6 +31,41 @@ public:
 
     void run(bool cappedFPS);
 
+    // Renders into an offscreen framebuffer of the window size without
+    // showing a window. Without a display (CI, build farm) it falls back to
+    // GLFW's null platform with a surfaceless EGL context, which works on
+    // Mesa llvmpipe. Key bindings are not polled. Returns false if no
+    // context could be created.
+    bool runHeadless(const HeadlessOptions& options = HeadlessOptions());
+    bool isHeadless() const { return m_offscreenFBO != 0; }
+
+    // Writes tightly packed, top-down RGBA pixels as a PNG
+    static bool saveImage(const std::string& path, int width, int height, const std::vector<unsigned char>& pixels);
+
+    // Runs the simulation (onFrameDrawn and key bindings) at a fixed tick rate
+    // instead of once per rendered frame. Slow frames run up to maxCatchUpSteps
+    // ticks, time beyond that is dropped. onDrawInterpolated gets the fraction
+    // of a tick elapsed since the last one for interpolation. tickRate <= 0
+    // switches back to one variable-length step per frame.
+    void setFixedTimestep(float tickRate, int maxCatchUpSteps = 5);
+    float getTickRate() const { return m_tickRate; }
+
+    // Makes run() hand the GL context to a render thread that runs onCreate,
+    // onDraw and the buffer swap, while the calling thread polls input and
+    // simulates the next frame (onFrameDrawn, key bindings, onFpsUpdate).
+    // At most one frame is in flight. The simulation side must not touch
+    // Graphics, shapes, lights or the camera directly; it records changes
+    // through getRenderCommands() instead. With a fixed timestep, record
+    // transforms with both the previous and the current tick's state to have
+    // them interpolated. Takes effect on the next run().
+    void setThreadedRendering(bool enabled);
+    bool isThreadedRendering() const { return m_threadedRendering; }
+
+    // Changes applied right before the next onDraw, on the thread owning the
+    // GL context. Works in every mode, so simulation code written for the
+    // threaded mode runs unchanged without it. Record from the simulation only.
+    RenderCommandList& getRenderCommands() { return m_commandLists[m_recording]; }
+
     void addKeyBinding(int key, std::function<void(float)> action);
 
     void removeKeyBinding(int key);
@@ -27,27 +73,69 @@ public:
 protected:
     virtual void onCreate(Graphics& graphics) {}
     virtual void onDraw(Graphics& graphics) {};
+    // alpha in [0, 1): progress towards the next fixed tick, always 1 without
+    // a fixed timestep. Called instead of onDraw; forwards to it unless overridden.
+    // Recorded render commands have already been applied at this alpha. In
+    // threaded mode this runs on the render thread while the next tick is
+    // simulated, so it must not read simulation state.
+    virtual void onDrawInterpolated(Graphics& graphics, float alpha) { onDraw(graphics); }
     virtual void onDestroy() {};
     virtual void onFpsUpdate(float fps) {};
+    // Called once per frame, or once per tick with a fixed timestep
+    // (deltaTime is then always 1 / tickRate)
     virtual void onFrameDrawn(float deltaTime) {};
+    // Headless mode with readback: RGBA8, top-down rows, width * height * 4 bytes
+    virtual void onFrameRead(int frame, const std::vector<unsigned char>& pixels) {};
 
     GLFWwindow* getWindow() const;
 
 private:
     static void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
+    bool createWindow(bool visible);
+    bool createOffscreenTarget();
+    void destroyOffscreenTarget();
+
 
     void onResize(int width, int height);
+    // Advances the simulation by one frame's worth of time
+    void simulate(float frameTime, bool pollKeys);
+    void applyRenderCommands();
+
+    void runThreaded(bool cappedFPS);
+    void renderThreadMain(bool cappedFPS);
+    // Hands the recorded list to the render thread once it finished the previous one
+    void submitFrame();
 
     int m_width;
     int m_height;
     const char* m_title;
     GLFWwindow* m_window;
     Graphics m_graphics;
+    GLuint m_offscreenFBO = 0;
+    GLuint m_offscreenColor = 0;
+    GLuint m_offscreenDepth = 0;
     using Clock = std::chrono::high_resolution_clock;
     Clock::time_point m_lastTime;
     Clock::time_point m_fpsLastReport;
     int m_frameCount = 0;
+    float m_tickRate = 0.0f;
+    int m_maxCatchUpSteps = 5;
+    float m_accumulator = 0.0f;
+    float m_alpha = 1.0f;
+
+    // Double-buffered: the simulation records into one list while the render thread draws the other
+    RenderCommandList m_commandLists[2];
+    int m_recording = 0;
+    bool m_threadedRendering = false;
+    bool m_renderThreadActive = false;
+    std::mutex m_renderMutex;
+    std::condition_variable m_renderCondition;
+    RenderCommandList* m_submitted = nullptr;  // Frame the render thread is drawing or about to draw
+    float m_submittedAlpha = 1.0f;
+    bool m_renderReady = false;
+    bool m_renderFailed = false;
+    bool m_renderQuit = false;
     std::unordered_map<int, std::function<void(float)>> keyBindings;
 
 };
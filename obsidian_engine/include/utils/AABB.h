@@ -0,0 +1,33 @@
+#ifndef AABB_H
+#define AABB_H
+
+#include "../includes.h"
+
+// Axis-aligned 2D box in world units
+struct AABB {
+    glm::vec2 min = glm::vec2(0.0f);
+    glm::vec2 max = glm::vec2(0.0f);
+
+    bool intersects(const AABB& other) const {
+        return min.x <= other.max.x && max.x >= other.min.x
+            && min.y <= other.max.y && max.y >= other.min.y;
+    }
+
+    // Box around `local` after transforming it with the 2D part of `m`
+    static AABB transformed(const AABB& local, const glm::mat4& m) {
+        glm::vec2 center = (local.min + local.max) * 0.5f;
+        glm::vec2 extent = (local.max - local.min) * 0.5f;
+
+        glm::vec2 worldCenter(
+            m[0][0] * center.x + m[1][0] * center.y + m[3][0],
+            m[0][1] * center.x + m[1][1] * center.y + m[3][1]
+        );
+        glm::vec2 worldExtent(
+            std::abs(m[0][0]) * extent.x + std::abs(m[1][0]) * extent.y,
+            std::abs(m[0][1]) * extent.x + std::abs(m[1][1]) * extent.y
+        );
+        return { worldCenter - worldExtent, worldCenter + worldExtent };
+    }
+};
+
+#endif // AABB_H
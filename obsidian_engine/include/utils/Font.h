@@ -5,11 +5,100 @@
 #ifndef FONT_H
 #define FONT_H
 
-struct Font {
-    GLuint textureID = 0;
-    stbtt_bakedchar cdata[96]; // ASCII 32..126
-    int bitmapWidth = 512;
-    int bitmapHeight = 512;
+#include "../includes.h"
+
+enum class FontMode {
+    Bitmap,  // Coverage at pixelHeight; sharpest at scale 1, blurs when scaled
+    SDF      // Signed distance field: one atlas serves every size and rotation, plus outlines and glows
+};
+
+// One rasterized glyph. The atlas rect is in pixels so it stays valid when the
+// atlas grows; divide by Font::atlasSize() for UVs.
+struct Glyph {
+    int x = 0;                 // Atlas rect, row 0 = top of the atlas
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    glm::vec2 offset{ 0.0f };  // Pen position to the bitmap's bottom-left corner, y up
+    float advance = 0.0f;
+    int index = 0;             // stb_truetype glyph index, used for kerning
+};
+
+// TrueType font rasterized on demand into a single-channel atlas texture.
+// Any codepoint can be requested; glyphs are packed on shelves and the atlas
+// doubles in height when it fills up, so all text drawn with one font shares
+// one texture. New glyphs reach the GPU on the next upload().
+//
+// In SDF mode the atlas stores distance to the glyph outline instead of
+// coverage: 0.5 on the edge, sdfSpread() pixels (at pixelHeight) from the
+// edge it reaches 0 outside and 1 inside. Glyph rects include that spread.
+class Font {
+public:
+    Font() = default;
+    ~Font();
+
+    Font(const Font&) = delete;
+    Font& operator=(const Font&) = delete;
+
+    // Copies the font file; pixelHeight is the em height glyphs are rasterized at.
+    // SDF fonts look sharp far above pixelHeight, 32-48 is usually plenty.
+    bool load(const unsigned char* data, int size, float pixelHeight, FontMode mode = FontMode::Bitmap);
+    void destroy();
+    bool loaded() const { return !m_data.empty(); }
+    // Bumped by load() and destroy(); glyph rects from an older revision are stale
+    uint32_t revision() const { return m_revision; }
+
+    // Rasterizes the glyph on first use. Codepoints the font lacks get its
+    // missing-glyph box.
+    const Glyph& glyph(uint32_t codepoint);
+    float kerning(const Glyph& left, const Glyph& right) const;
+
+    FontMode mode() const { return m_mode; }
+    float sdfSpread() const { return m_sdfSpread; }
+    float pixelHeight() const { return m_pixelHeight; }
+    float ascent() const { return m_ascent; }
+    float descent() const { return m_descent; }          // Negative, below the baseline
+    float lineHeight() const { return m_ascent - m_descent + m_lineGap; }
+
+    // Sends glyphs added since the last call to the atlas texture
+    // (re-creating it if the atlas grew). Returns the bytes uploaded.
+    size_t upload();
+    GLuint texture() const { return m_texture; }
+    glm::ivec2 atlasSize() const { return glm::ivec2(m_atlasWidth, m_atlasHeight); }
+    size_t glyphCount() const { return m_glyphs.size(); }
+
+    // Decodes the UTF-8 sequence at text[i] and advances i past it.
+    // Malformed bytes decode as U+FFFD.
+    static uint32_t decodeUtf8(const std::string& text, size_t& i);
+
+private:
+    bool allocate(int width, int height, int& outX, int& outY);
+
+    std::vector<unsigned char> m_data;
+    stbtt_fontinfo m_info{};
+    FontMode m_mode = FontMode::Bitmap;
+    uint32_t m_revision = 0;
+    float m_sdfSpread = 0.0f;
+    float m_pixelHeight = 0.0f;
+    float m_scale = 0.0f;
+    float m_ascent = 0.0f;
+    float m_descent = 0.0f;
+    float m_lineGap = 0.0f;
+
+    std::unordered_map<uint32_t, Glyph> m_glyphs;
+
+    // CPU copy of the atlas, kept so growing never needs a GPU readback
+    std::vector<unsigned char> m_pixels;
+    int m_atlasWidth = 512;
+    int m_atlasHeight = 0;
+    int m_shelfX = 0;       // Shelf packer: glyphs fill the current row left to right
+    int m_shelfY = 0;
+    int m_shelfHeight = 0;
+
+    GLuint m_texture = 0;
+    int m_textureHeight = 0;  // Height the GL texture was allocated with
+    int m_dirtyTop = 0;       // Rows [m_dirtyTop, m_dirtyBottom) changed since upload()
+    int m_dirtyBottom = 0;
 };
 
 #endif //FONT_H
@@ -0,0 +1,49 @@
+#ifndef GBUFFER_H
+#define GBUFFER_H
+
+#include "../includes.h"
+
+// Per-light instance attributes of the deferred light pass
+struct LightInstance {
+    glm::vec4 light;  // xy = position, z = radius, w = ShadowMap row coordinate
+    glm::vec4 color;  // rgb = color * intensity
+};
+
+// Render targets for deferred lighting: shapes draw their unlit color into
+// the albedo texture, lights add into the floating point light texture, and
+// a composite pass multiplies the two into the output framebuffer.
+class GBuffer {
+public:
+    GBuffer() = default;
+    ~GBuffer();
+
+    GBuffer(const GBuffer&) = delete;
+    GBuffer& operator=(const GBuffer&) = delete;
+
+    // (Re)allocates the textures when the size changed. Returns false if a
+    // framebuffer is incomplete.
+    bool resize(int width, int height);
+    void destroy();
+
+    // Binds the albedo target and clears it to transparent black
+    void beginGeometry();
+    // Binds the light target and clears it to `ambient`, the light every pixel gets
+    void beginLights(const glm::vec3& ambient);
+
+    GLuint albedo() const { return m_albedo; }
+    GLuint light() const { return m_light; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+private:
+    static GLuint createTarget(GLuint framebuffer, GLint internalFormat, GLenum type, int width, int height);
+
+    GLuint m_albedoFBO = 0;
+    GLuint m_albedo = 0;
+    GLuint m_lightFBO = 0;
+    GLuint m_light = 0;
+    int m_width = 0;
+    int m_height = 0;
+};
+
+#endif // GBUFFER_H
@@ -4,11 +4,75 @@
 #include "./Camera.h"
 #include "./Shape.h"
 #include "./Font.h"
+#include "TextureRegistry.h"
+#include "TextureLoader.h"
+#include "ShaderProgram.h"
 #include "LightSource.h"
+#include "SpriteBatch.h"
+#include "InstancedShape.h"
+#include "SpatialGrid.h"
+#include "RenderQueue.h"
+#include "ShadowMap.h"
+#include "GBuffer.h"
+#include "LightGrid.h"
+#include "Profiler.h"
 #include "../includes.h"
 
 class Obsidian;
 
+using ShapeHandle = SlotHandle;
+
+enum class RenderMode {
+    Immediate,  // One draw call per shape
+    Batched     // Consecutive shapes sharing shader/texture/primitive are merged
+};
+
+enum class LightingMode {
+    Forward,   // Every fragment loops over the light buffer (up to the light budget)
+    Deferred,  // Shapes write albedo, each point light adds a quad bounded by its radius
+    Tiled      // Forward, but each fragment only walks the lights binned to its screen tile
+};
+
+struct RenderStats {
+    int drawCalls = 0;
+    int shapes = 0;
+    int vertices = 0;
+    size_t streamedBytes = 0;  // Written to the per-frame stream buffer
+    int streamStalls = 0;      // Frames that waited on the GPU for a stream region
+    int culled = 0;            // Shapes skipped because they were off screen
+    size_t sortMoves = 0;      // Items the render queue had to move to stay sorted
+    int shadowUpdates = 0;     // Shadow map rows redrawn because a light or caster moved
+    int stateChanges = 0;      // Program and texture binds
+    size_t uploadedBytes = 0;  // Everything sent to the GPU: streamed vertices, uniforms, light lists, textures
+};
+
+// Per-light instance attributes of the glow pass
+struct GlowInstance {
+    glm::vec4 light;      // xy = position, z = radius, w = ShadowMap row coordinate
+    glm::vec4 direction;  // xy = direction, z = cutoff cosine
+    glm::vec4 color;      // rgb = color, a = intensity
+};
+
+// Per-glyph instance attributes of the text pass
+struct TextInstance {
+    glm::vec4 position;  // xy = bottom-left corner, zw = bottom edge (width and direction)
+    glm::vec4 up;        // xy = left edge (height and direction), z = 1 for window pixels
+    glm::vec4 glyph;     // Font atlas rect in pixels: xy = top-left, zw = size
+    glm::vec4 color;
+    glm::vec4 outline;   // rgb = color, a = width in font pixels (SDF fonts only)
+    glm::vec4 glow;      // rgb = color, a = radius in font pixels (SDF fonts only)
+};
+
+// Effects applied to text queued after Graphics::setTextStyle. Widths are in
+// font pixels (at Font::pixelHeight) so they scale with the text, and are
+// limited to Font::sdfSpread(). Only SDF fonts draw them.
+struct TextStyle {
+    glm::vec3 outlineColor{ 0.0f };
+    float outlineWidth = 0.0f;
+    glm::vec3 glowColor{ 0.0f };
+    float glowRadius = 0.0f;
+};
+
 class Graphics {
     friend class Obsidian;
 
@@ -30,24 +94,100 @@ public:
 
     void clear(float r, float g, float b, float a);
 
-    void addShape(std::shared_ptr<Shape> shape);
+    // Shapes are registered in a generational slot map: add, remove and lookup
+    // are O(1) and removed shapes leave nothing behind for render() to visit
+    ShapeHandle addShape(std::shared_ptr<Shape> shape);
+    bool removeShape(ShapeHandle handle);
+    bool removeShape(const std::shared_ptr<Shape>& shape);
+    std::shared_ptr<Shape> getShape(ShapeHandle handle) const;
+    size_t getShapeCount() const;
+    // Releases storage left over from mass removals
+    void compactShapes();
+
+    // Lights and instanced groups are few; removing one searches its list
+    void addInstancedShape(std::shared_ptr<InstancedShape> shape);
+    bool removeInstancedShape(const std::shared_ptr<InstancedShape>& shape);
     void addLight(std::shared_ptr<LightSource> source);
+    bool removeLight(const std::shared_ptr<LightSource>& source);
     void render();  // Renders all visible shapes
 
+    void setRenderMode(RenderMode mode);
+    RenderMode getRenderMode() const;
+    const RenderStats& getStats() const;  // Counters from the last render() call
+
+    // Frame profiler, disabled by default. Obsidian::run opens one profiler
+    // frame per loop iteration; render() opens its own when called outside one.
+    Profiler& getProfiler();
+
+    // Consecutive shapes sharing one mesh (see Shape::share) are drawn instanced
+    // once a run reaches this length. 0 disables automatic instancing.
+    void setInstancingThreshold(int minShapes);
+
+    // Only shapes whose world bounds intersect the camera rectangle are sorted
+    // and drawn (default on). Cell size is in world units.
+    void setCulling(bool enabled);
+    void setCullingCellSize(float cellSize);
+    AABB getViewBounds() const;  // World-space rectangle seen by the camera
+
+    // Vertex layout for shapes and streamed geometry. Packed halves the vertex
+    // size but clamps colors and UVs to [0, 1]. Existing and future shapes are converted.
+    void setVertexFormat(VertexFormat format);
+    VertexFormat getVertexFormat() const;
+
+    // Maximum number of lights the shaders see (default 128). Lights live in a
+    // std140 uniform block, so the budget is capped by GL_MAX_UNIFORM_BLOCK_SIZE.
+    void setLightBudget(int maxLights);
+    int getLightBudget() const;
+
+    // Deferred lighting scales with lit pixels instead of fragments x lights
+    // and ignores the light budget. Custom shaders write albedo in this mode.
+    // Tiled keeps forward blending and draw order and ignores the budget too.
+    void setLightingMode(LightingMode mode);
+    LightingMode getLightingMode() const;
+    void setLightTileSize(int pixels);  // Tiled mode, default 32
+
+    // Point lights with castsShadows are blocked by shapes with castsShadow.
+    // Resolution is the number of directions sampled per light (default 1024).
+    void setShadowResolution(int texels);
+
     // Shader / Texture / Uniform utilities
     bool loadShader(const std::string& vertexSrc, const std::string& fragmentSrc, const std::string& shaderName);
     void useShader(const std::string& shaderName);
     void setUniformMat4(const std::string& shaderName, const std::string& uniform, const glm::mat4& matrix);
-    void renderLightGlow(const LightSource& light);
+    void renderLightGlow(const LightSource& light);  // Draws one glow immediately
     void bindTexture(GLuint tex);
 
     GLuint loadTexture(const std::string& path, GLint filtering = GL_LINEAR);
     GLuint getDefaultTexture();
+    TextureRegistry& getTextures();
+
+    // Decodes on worker threads and uploads during render(); the handle shows
+    // the white texture until then. Callbacks run on the render thread.
+    Texture loadTextureAsync(const std::string& path, GLint filtering = GL_LINEAR,
+                             TextureReadyCallback onReady = nullptr);
+    TextureLoader& getTextureLoader();
 
-    // Text rendering
-    bool loadFont(const unsigned char* fontBuffer, int fontBufferSize, float pixelHeight = 32.0f);
+    // Time render() may spend uploading async textures each frame (default 2 ms)
+    void setTextureUploadBudget(double milliseconds);
+
+    // Text rendering. Strings are UTF-8 and '\n' starts a new line; position
+    // is the baseline origin of the first line. Text is queued and drawn on
+    // top of everything by the next render(), all strings in one draw call.
+    // Text that rarely changes is cheaper as a TextMesh added like a shape.
+    // FontMode::SDF keeps text sharp at any scale and enables TextStyle effects.
+    bool loadFont(const unsigned char* fontBuffer, int fontBufferSize, float pixelHeight = 32.0f,
+                  FontMode mode = FontMode::Bitmap);
+    bool loadFont(const std::string& path, float pixelHeight = 32.0f, FontMode mode = FontMode::Bitmap);
+    // In world units, through the camera
     void renderText(const std::string& text, const glm::vec2& position, float scale,
                     glm::vec3 color, float rotationDegrees = 0.0f);
+    // In window pixels from the bottom-left corner, unaffected by the camera
+    void renderScreenText(const std::string& text, const glm::vec2& position, float scale, glm::vec3 color);
+    // Width of the widest line and total height, at the given scale
+    glm::vec2 measureText(const std::string& text, float scale);
+    void setTextStyle(const TextStyle& style);
+    const TextStyle& getTextStyle() const;
+    Font& getFont();
 
     void cleanup();
 
@@ -57,17 +197,99 @@ private:
     GLuint compileShader(GLenum type, const std::string& source);
     GLuint linkProgram(GLuint vertexShader, GLuint fragmentShader);
 
-    std::unordered_map<std::string, GLuint> shaderPrograms;
+    const ShaderProgram* programFor(const Shape& shape) const;
+    void batchShape(Shape& shape, const glm::mat4& viewProjection);
+    void flushBatch(const glm::mat4& viewProjection);
+
+    static bool canInstance(const Shape& a, const Shape& b);
+    void drawInstanced(Shape& mesh, const InstanceData* data, size_t count);
+    void drawDynamic(Shape& shape, const glm::mat4& view, const glm::mat4& projection, const ShaderProgram& program);
+
+    bool loadBuiltinShaders();
+    void updateFrameBuffer(const glm::mat4& view, const glm::mat4& projection);
+    void updateLightBuffer();
+    void renderFrame();
+    void renderDeferredLights(GLuint target, const GLint viewport[4]);
+    void queueGlow(const LightSource& light, const AABB& view);
+    void flushGlows();
+    void queueText(const std::string& text, const glm::vec2& position, float scale, const glm::vec4& color,
+                   float rotationDegrees, bool screenSpace);
+    void flushText();
+
+    void bindProgram(const ShaderProgram& program);
+    const ShaderProgram* findProgram(const std::string& shaderName) const;
+
+    std::unordered_map<std::string, ShaderProgram> shaderPrograms;
     GLuint currentProgram = 0;
+    GLuint currentTexture = 0;  // Unit 0, as last bound by bindTexture
+
+    // Built-in programs, resolved once in initialize()
+    const ShaderProgram* m_defaultProgram = nullptr;
+    const ShaderProgram* m_instancedProgram = nullptr;
+    const ShaderProgram* m_glowProgram = nullptr;
+    const ShaderProgram* m_shadowProgram = nullptr;
+    const ShaderProgram* m_deferredLightProgram = nullptr;
+    const ShaderProgram* m_compositeProgram = nullptr;
+    const ShaderProgram* m_textProgram = nullptr;
+    const ShaderProgram* m_textSdfProgram = nullptr;
 
-    GLuint whiteTexture = 0;
+    TextureRegistry m_textures;
+    MeshRegistry m_meshes;
+    // Handles behind ids returned by loadTexture, one per registry key
+    std::unordered_map<std::string, Texture> m_pinnedTextures;
+    TextureLoader m_loader;
+    double m_uploadBudgetMs = 2.0;
     GLuint VAO = 0, VBO = 0;
 
     Camera m_camera = Camera(glm::vec2(0.f, 0.f));
     Font m_font;
+    TextStyle m_textStyle;
+
+    RenderMode m_renderMode = RenderMode::Immediate;
+    RenderStats m_stats;
+    SpriteBatch m_batch;
+
+    // Per-frame vertex and instance data (batches, instancing, dynamic shapes)
+    StreamBuffer m_stream;
+    int m_instancingThreshold = 16;
+    std::vector<InstanceData> m_instanceScratch;
 
-    std::vector<std::shared_ptr<Shape>> shapes;  // Collection of shapes to render
+    // Uniform buffers shared by all programs (see UniformBlock)
+    GLuint m_frameUBO = 0;
+    GLuint m_lightsUBO = 0;
+    int m_lightBudget = 128;
+    bool m_frameUploaded = false;
+    bool m_lightsUploaded = false;
+    glm::mat4 m_uploadedView = glm::mat4(1.0f);
+    glm::mat4 m_uploadedProjection = glm::mat4(1.0f);
+    std::vector<GpuLight> m_packedLights;
+    std::vector<GpuLight> m_uploadedLights;
+
+    SlotMap<std::shared_ptr<Shape>> shapes;  // Collection of shapes to render
+    std::vector<std::shared_ptr<InstancedShape>> instancedShapes;
+
+    // Declared after `shapes` so it is destroyed first, while the shapes are still alive
+    SpatialGrid m_grid;
+    bool m_culling = true;
+    std::vector<Shape*> m_visibleShapes;
+    RenderQueue m_queue;
     std::vector<std::shared_ptr<LightSource>> lights;
+    ShadowMap m_shadows;
+
+    LightingMode m_lightingMode = LightingMode::Forward;
+    GBuffer m_gbuffer;
+    GLuint m_cornerVBO = 0;  // -1..1 quad drawn per instance by the light passes
+    GLuint m_lightQuadVAO = 0;
+    GLuint m_compositeVAO = 0;
+    GLuint m_glowVAO = 0;
+    GLuint m_textVAO = 0;
+    std::vector<TextInstance> m_textInstances;
+    std::vector<GlowInstance> m_glowInstances;
+    std::vector<LightInstance> m_lightInstances;
+    LightGrid m_lightGrid;
+
+    Profiler m_profiler;
+    size_t m_loaderBytes = 0;  // TextureLoader byte count at the end of the last frame
 };
 
 #endif // GRAPHICS_H
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef INSTANCEDSHAPE_H
+#define INSTANCEDSHAPE_H
+
+#include "Shape.h"
+#include "../includes.h"
+
+// Per-instance attributes streamed next to a shared mesh (locations 3..8)
+struct InstanceData {
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::vec4 tint = glm::vec4(1.0f);
+    glm::vec4 uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);  // xy = offset, zw = size
+};
+
+// Draws many copies of one mesh with a single instanced draw call.
+// Intended for particles, tiles and other large sets of identical geometry.
+class InstancedShape {
+public:
+    std::shared_ptr<Shape> mesh;  // Geometry, texture and primitive type shared by all instances
+    std::vector<InstanceData> instances;
+    float depth = 0;
+    bool isVisible = true;
+
+    explicit InstancedShape(std::shared_ptr<Shape> mesh) : mesh(std::move(mesh)) {}
+
+    size_t addInstance(const glm::mat4& model,
+                       const glm::vec4& tint = glm::vec4(1.0f),
+                       const glm::vec4& uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)) {
+        instances.push_back({ model, tint, uvRect });
+        return instances.size() - 1;
+    }
+
+    size_t addInstance(const glm::vec2& position, const glm::vec4& tint = glm::vec4(1.0f)) {
+        return addInstance(glm::translate(glm::mat4(1.0f), glm::vec3(position, 0.0f)), tint);
+    }
+
+    void clear() { instances.clear(); }
+    size_t size() const { return instances.size(); }
+};
+
+#endif // INSTANCEDSHAPE_H
@@ -0,0 +1,63 @@
+#ifndef LIGHT_GRID_H
+#define LIGHT_GRID_H
+
+#include "LightSource.h"
+#include "ShadowMap.h"
+#include "../includes.h"
+
+// Screen-space light binning for tiled forward shading. Point lights are
+// assigned to the square tiles their radius covers, and the per-tile lists
+// are uploaded to two texture buffers the default fragment shader walks.
+//
+// uLightData (RGBA32F):  [0] rgb = ambient + directional light, w = tiles per row
+//                        [1] x = tile size in pixels
+//                        [2 + 2i] xy = position, z = radius, w = ShadowMap row
+//                        [3 + 2i] rgb = color * intensity
+// uLightTiles (R32I):    [2t] first list entry, [2t + 1] count, then the lists
+class LightGrid {
+public:
+    LightGrid() = default;
+    ~LightGrid();
+
+    LightGrid(const LightGrid&) = delete;
+    LightGrid& operator=(const LightGrid&) = delete;
+
+    void destroy();
+
+    void setTileSize(int pixels) { m_tileSize = std::max(pixels, 4); }
+    int getTileSize() const { return m_tileSize; }
+
+    // Rebins every light for the current camera and re-uploads what changed.
+    // Returns the number of bytes uploaded.
+    size_t update(const std::vector<std::shared_ptr<LightSource>>& lights, const ShadowMap& shadows,
+                const glm::mat4& viewProjection, int width, int height);
+
+    // Binds the two buffer textures to the given units
+    void bind(GLint dataUnit, GLint tileUnit) const;
+
+    size_t lightCount() const { return m_lightCount; }  // Point lights binned last update
+    size_t entryCount() const { return m_entries; }     // Tile list entries, a light counts once per tile
+
+private:
+    static void upload(GLuint buffer, const void* data, size_t bytes);
+
+    int m_tileSize = 32;
+
+    GLuint m_dataBuffer = 0;
+    GLuint m_dataTexture = 0;
+    GLuint m_tileBuffer = 0;
+    GLuint m_tileTexture = 0;
+
+    std::vector<glm::vec4> m_data;
+    std::vector<glm::vec4> m_uploadedData;
+    std::vector<GLint> m_tiles;
+    std::vector<GLint> m_uploadedTiles;
+
+    // Scratch: tile rectangle of each binned light
+    std::vector<glm::ivec4> m_rects;
+
+    size_t m_lightCount = 0;
+    size_t m_entries = 0;
+};
+
+#endif // LIGHT_GRID_H
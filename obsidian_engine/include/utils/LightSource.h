@@ -19,6 +19,9 @@ struct LightSource {
     float cutoff = glm::cos(glm::radians(12.5f)); // For spotlight if ever needed
     float radius = 100;
     float depth = 0;
+    // Point lights only: shapes with Shape::castsShadow block this light.
+    // Graphics keeps the shadow in its polar ShadowMap, not in shadowMap below.
+    bool castsShadows = false;
 
     // Shadow mapping resources
     GLuint shadowFBO = 0;
@@ -0,0 +1,58 @@
+#ifndef MESH_REGISTRY_H
+#define MESH_REGISTRY_H
+
+#include <mutex>
+#include "../includes.h"
+
+struct MeshRegistryState {
+    std::mutex mutex;
+    // Released meshes waiting for MeshRegistry::collect()
+    std::vector<GLuint> vertexArrays;
+    std::vector<GLuint> buffers;
+    bool contextAlive = true;
+};
+
+// VAO and buffers behind one or more shapes (see Shape::share), freed with
+// the last shape that draws from them
+struct MeshResource {
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint ebo = 0;
+    // Empty for meshes created without an active registry. Shared so a mesh
+    // outliving the registry still sees contextAlive == false and leaves GL alone.
+    std::shared_ptr<MeshRegistryState> registry;
+
+    ~MeshResource();
+};
+
+// Tracks the GL objects of shape geometry. Owned by Graphics; while
+// initialized it is the registry Shape constructors create meshes in.
+// A mesh can lose its last shape on any thread (e.g. the simulation thread
+// in threaded mode), so releases are only queued and collect() deletes them
+// on the thread that owns the context.
+class MeshRegistry {
+public:
+    MeshRegistry() = default;
+    ~MeshRegistry();
+
+    MeshRegistry(const MeshRegistry&) = delete;
+    MeshRegistry& operator=(const MeshRegistry&) = delete;
+
+    static MeshRegistry* active();
+
+    void initialize();  // Becomes active
+    void shutdown();    // Collects pending releases; GL context must still be current
+
+    // Generates a VAO and VBO; the element buffer is added once the shape has indices
+    static std::shared_ptr<MeshResource> create();
+
+    // Deletes the meshes released since the last call, returns how many GL objects went
+    size_t collect();
+
+private:
+    std::shared_ptr<MeshRegistryState> m_state;
+    std::vector<GLuint> m_vertexArrays;  // Scratch for collect(), swapped with the pending lists
+    std::vector<GLuint> m_buffers;
+};
+
+#endif // MESH_REGISTRY_H
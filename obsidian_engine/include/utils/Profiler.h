@@ -0,0 +1,139 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include "../includes.h"
+
+// GPU passes timed by Graphics::render()
+enum class GpuPass {
+    Clear,
+    Shadows,
+    Lights,   // Deferred light accumulation, composite and glows
+    Shapes,
+    Text,
+    Count
+};
+
+struct CpuEvent {
+    const char* name;   // Must outlive the profiler, normally a string literal
+    double startUs;     // Since the profiler was created
+    double durationUs;
+    int depth;          // Nesting level, 0 = outermost
+};
+
+struct GpuEvent {
+    GpuPass pass;
+    double durationMs;
+};
+
+// Renderer counters, filled in by Graphics at the end of render()
+struct FrameCounters {
+    int drawCalls = 0;
+    int stateChanges = 0;      // Program and texture binds
+    int vertices = 0;
+    size_t uploadedBytes = 0;  // Streamed vertices, uniform/texture buffers and texture uploads
+};
+
+struct FrameProfile {
+    uint64_t frame = 0;
+    double startUs = 0.0;
+    double cpuMs = 0.0;   // beginFrame() to endFrame()
+    std::vector<CpuEvent> cpuEvents;
+
+    // Filled in a few frames later, once the timer queries are available
+    bool gpuResolved = false;
+    std::vector<GpuEvent> gpuEvents;
+    std::array<double, static_cast<size_t>(GpuPass::Count)> gpuMs{};
+
+    FrameCounters counters;
+
+    double gpuTotalMs() const {
+        double total = 0.0;
+        for (double ms : gpuMs) total += ms;
+        return total;
+    }
+};
+
+// Frame profiler: CPU scopes, GPU pass timings from GL_TIME_ELAPSED queries
+// and renderer counters for the last few hundred frames. Query results are
+// read back GpuLatency frames late so the CPU never waits for the GPU.
+// Disabled by default; when disabled every call is a cheap no-op.
+class Profiler {
+public:
+    static constexpr int GpuLatency = 4;
+
+    Profiler();
+    ~Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    void destroy();  // Deletes the query objects; GL context must be current
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled; }
+
+    void setHistorySize(size_t frames);  // Default 300
+
+    void beginFrame();
+    void endFrame();
+    bool inFrame() const { return m_inFrame; }
+
+    // Ends the running GPU timer and starts one for `pass`; GpuPass::Count
+    // only stops timing. Returns the pass that was running, so callers can
+    // switch back. GL_TIME_ELAPSED queries cannot nest.
+    GpuPass switchGpuPass(GpuPass pass);
+
+    void setCounters(const FrameCounters& counters);
+
+    // Times the enclosing block into the current frame
+    class CpuScope {
+    public:
+        CpuScope(Profiler& profiler, const char* name);
+        ~CpuScope();
+
+        CpuScope(const CpuScope&) = delete;
+        CpuScope& operator=(const CpuScope&) = delete;
+
+    private:
+        Profiler* m_profiler;
+        size_t m_event;
+    };
+
+    const std::deque<FrameProfile>& history() const { return m_history; }
+    // Newest frame whose GPU timings are in, or nullptr
+    const FrameProfile* latest() const;
+
+    // Writes the history in the Chrome trace event format (chrome://tracing,
+    // Perfetto). GPU passes are laid out back to back from the frame start.
+    bool writeChromeTrace(const std::string& path) const;
+
+    static const char* passName(GpuPass pass);
+
+private:
+    struct GpuFrame {
+        uint64_t frame = 0;
+        bool pending = false;
+        std::vector<GLuint> queries;  // Pool, reused every GpuLatency frames
+        std::vector<GpuPass> passes;  // Pass of each used query
+    };
+
+    double nowUs() const;
+    void resolve(GpuFrame& slot);
+    FrameProfile* find(uint64_t frame);
+
+    bool m_enabled = false;
+    bool m_inFrame = false;
+    size_t m_historySize = 300;
+    uint64_t m_frame = 0;
+    int m_depth = 0;
+    std::chrono::steady_clock::time_point m_origin;
+
+    std::deque<FrameProfile> m_history;
+    std::array<GpuFrame, GpuLatency> m_gpuFrames;
+    GpuPass m_activePass = GpuPass::Count;
+};
+
+#endif // PROFILER_H
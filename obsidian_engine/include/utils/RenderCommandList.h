@@ -0,0 +1,97 @@
+#ifndef RENDER_COMMAND_LIST_H
+#define RENDER_COMMAND_LIST_H
+
+#include "Shape.h"
+#include "LightSource.h"
+#include "../includes.h"
+
+class Graphics;
+
+// Scene changes recorded by the simulation and applied where the GL context
+// lives (see Obsidian::setThreadedRendering). Values are copied when they are
+// recorded, so a list is a snapshot: the simulation can move on to the next
+// frame while an earlier list is being drawn. Commands apply in recording order.
+// Transforms and the camera can carry the state of the previous tick as well;
+// execute() then blends the two by alpha (see Obsidian::onDrawInterpolated).
+class RenderCommandList {
+public:
+    using Callback = std::function<void(Graphics&)>;
+
+    struct Transform {
+        glm::vec2 position = glm::vec2(0.0f);
+        float rotation = 0.0f;  // Degrees
+        glm::vec2 scale = glm::vec2(1.0f);
+    };
+
+    void setTransform(std::shared_ptr<Shape> shape, const glm::vec2& position, float rotationDegrees,
+                      const glm::vec2& scale = glm::vec2(1.0f));
+    // Drawn at previous + (current - previous) * alpha; rotation takes the shorter way round
+    void setTransform(std::shared_ptr<Shape> shape, const Transform& previous, const Transform& current);
+    void setTint(std::shared_ptr<Shape> shape, const glm::vec4& tint);
+    void setVisible(std::shared_ptr<Shape> shape, bool visible);
+    // Copies position, direction, color, intensity, cutoff and radius
+    void setLight(std::shared_ptr<LightSource> light, const LightSource& state);
+    void setCamera(const glm::vec2& position, float zoom = 1.0f);
+    void setCamera(const glm::vec2& previousPosition, float previousZoom, const glm::vec2& position, float zoom);
+    // Anything else (adding shapes, editing geometry, renderText); runs with the GL context current
+    void run(Callback callback);
+
+    // alpha in [0, 1] picks between the previous and current state of interpolated commands
+    void execute(Graphics& graphics, float alpha = 1.0f);
+    void clear();
+
+    bool empty() const { return m_commands.empty(); }
+    size_t size() const { return m_commands.size(); }
+
+private:
+    enum class Type : uint8_t { Transform, Tint, Visible, Light, Camera, Callback };
+
+    // Payloads live in one array per type; commands only keep the order
+    struct Command {
+        Type type;
+        uint32_t index;
+    };
+
+    struct ShapeTransform {
+        std::shared_ptr<Shape> shape;
+        Transform previous;  // Same as current unless recorded with both
+        Transform current;
+    };
+
+    struct ShapeValue {
+        std::shared_ptr<Shape> shape;
+        glm::vec4 value;  // Tint, or x = visible
+    };
+
+    struct LightState {
+        std::shared_ptr<LightSource> light;
+        glm::vec2 position;
+        glm::vec2 direction;
+        glm::vec3 color;
+        float intensity;
+        float cutoff;
+        float radius;
+    };
+
+    struct CameraState {
+        glm::vec2 previousPosition;
+        float previousZoom;
+        glm::vec2 position;
+        float zoom;
+    };
+
+    template <typename T>
+    void push(Type type, std::vector<T>& payloads, T&& payload) {
+        m_commands.push_back({ type, static_cast<uint32_t>(payloads.size()) });
+        payloads.push_back(std::move(payload));
+    }
+
+    std::vector<Command> m_commands;
+    std::vector<ShapeTransform> m_transforms;
+    std::vector<ShapeValue> m_shapeValues;
+    std::vector<LightState> m_lights;
+    std::vector<CameraState> m_cameras;
+    std::vector<Callback> m_callbacks;
+};
+
+#endif // RENDER_COMMAND_LIST_H
@@ -0,0 +1,132 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "Shape.h"
+#include "InstancedShape.h"
+#include "LightSource.h"
+#include "../includes.h"
+
+// One draw submission. Objects are owned by Graphics' shape/light lists,
+// the queue only keeps raw pointers.
+struct RenderItem {
+    enum class Kind : uint8_t { Light, Shape, Instanced };
+
+    uint64_t key = 0;    // See RenderQueue::makeKey
+    uint64_t order = 0;  // Insertion order, breaks ties between equal keys
+    Kind kind = Kind::Shape;
+    union {
+        LightSource* light;
+        Shape* shape;
+        InstancedShape* instanced;
+    };
+
+    RenderItem() : shape(nullptr) {}
+
+    const void* object() const {
+        switch (kind) {
+            case Kind::Light:     return light;
+            case Kind::Instanced: return instanced;
+            case Kind::Shape:     break;
+        }
+        return shape;
+    }
+};
+
+// Sorted list of draw submissions that persists across frames. Each frame
+// it is rebuilt from the previous frame's order: items still visible keep
+// their place, new ones are appended, and an insertion sort fixes up the
+// few that moved. An unchanged scene costs one pass and n - 1 comparisons
+// instead of a full sort; heavily shuffled lists fall back to std::sort.
+class RenderQueue {
+public:
+    // 64-bit key: depth | kind | program | texture | mesh. Lights sort before
+    // everything else at equal depth; the remaining bits group equal-depth
+    // items by state so they batch and instance. Only the low bits of the GL
+    // names are kept, a collision merely costs a state change.
+    static uint64_t makeKey(float depth, RenderItem::Kind kind, GLuint program, GLuint texture, GLuint mesh);
+
+    // Lights and instanced groups stay queued until removed
+    void add(LightSource* light, float depth);
+    void add(InstancedShape* group, float depth);
+    // Shapes join the frame they are first visible; this fixes their tie-break order
+    void track(Shape* shape);
+    // O(1) for shapes: the item is dropped during the next update() without
+    // being dereferenced, so the shape may be destroyed right away
+    void remove(Shape* shape);
+    void remove(const void* object);
+    void clear();
+
+    // Rebuilds the list for this frame from the visible shapes plus every
+    // queued light and group. keyOf(item) returns the item's current key.
+    template <typename KeyFn>
+    void update(const std::vector<Shape*>& visible, KeyFn&& keyOf);
+
+    const std::vector<RenderItem>& items() const { return m_items; }
+
+    // Element moves done by the last update's insertion sort
+    size_t lastSortMoves() const { return m_sortMoves; }
+
+private:
+    void sort();
+
+    std::vector<RenderItem> m_items;
+    std::vector<RenderItem> m_next;
+    std::vector<RenderItem> m_added;  // Lights/groups added since the last update
+    std::vector<const Shape*> m_removed;  // Shapes removed since the last update
+    uint64_t m_nextOrder = 0;
+    uint32_t m_frame = 0;
+    size_t m_sortMoves = 0;
+};
+
+template <typename KeyFn>
+void RenderQueue::update(const std::vector<Shape*>& visible, KeyFn&& keyOf) {
+    if (++m_frame == 0) m_frame = 1;
+
+    for (Shape* shape : visible) {
+        shape->m_queueFrame = m_frame;
+    }
+
+    // Removed shapes may already be freed; drop them by address first
+    if (!m_removed.empty()) {
+        std::sort(m_removed.begin(), m_removed.end());
+        m_items.erase(std::remove_if(m_items.begin(), m_items.end(), [this](const RenderItem& item) {
+            return item.kind == RenderItem::Kind::Shape
+                && std::binary_search(m_removed.begin(), m_removed.end(), item.shape);
+        }), m_items.end());
+        m_removed.clear();
+    }
+
+    m_next.clear();
+    for (RenderItem& item : m_items) {
+        if (item.kind == RenderItem::Kind::Shape) {
+            // Culled or hidden since the last frame
+            if (item.shape->m_queueFrame != m_frame) continue;
+            // Mark as carried over so it is not appended again below
+            item.shape->m_queueFrame = 0;
+        }
+        item.key = keyOf(item);
+        m_next.push_back(item);
+    }
+
+    for (RenderItem& item : m_added) {
+        item.key = keyOf(item);
+        m_next.push_back(item);
+    }
+    m_added.clear();
+
+    for (Shape* shape : visible) {
+        if (shape->m_queueFrame != m_frame) continue;
+
+        RenderItem item;
+        item.kind = RenderItem::Kind::Shape;
+        item.shape = shape;
+        item.order = shape->m_renderOrder;
+        item.key = keyOf(item);
+        m_next.push_back(item);
+    }
+
+    m_items.swap(m_next);
+    sort();
+}
+
+#endif // RENDER_QUEUE_H
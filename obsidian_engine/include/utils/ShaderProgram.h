@@ -0,0 +1,75 @@
+#ifndef SHADERPROGRAM_H
+#define SHADERPROGRAM_H
+
+#include <array>
+#include "../includes.h"
+
+// Uniforms the engine sets itself. Locations are resolved once when the
+// program is loaded, so render paths index a table instead of asking the driver.
+enum class UniformID {
+    MVP,
+    Model,
+    View,
+    Texture,
+    Tint,
+    UVRect,
+    LightPos,
+    LightDir,
+    Cutoff,
+    LightColor,
+    Intensity,
+    Radius,
+    ShadowMap,
+    ShadowRow,
+    Count
+};
+
+// Binding points of the uniform blocks shared by every program.
+// Any shader declaring a block with one of these names is wired up on load.
+enum class UniformBlock : GLuint {
+    Frame = 0,   // "FrameData"
+    Lights = 1   // "Lights"
+};
+
+// std140 mirror of the FrameData block
+struct FrameBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProj;
+    glm::vec4 time;  // x = seconds since start
+};
+
+// std140 mirror of one element of the Lights block
+struct GpuLight {
+    glm::vec4 position;   // xy = position, w = LightType
+    glm::vec4 direction;  // xy = direction
+    glm::vec4 color;      // rgb = color, a = intensity
+    glm::vec4 params;     // x = cutoff, y = radius, z = ShadowMap row coordinate or -1
+
+    // The block starts with the light count, padded to one 16 byte slot
+    static constexpr size_t headerSize = 16;
+};
+
+struct ShaderProgram {
+    GLuint id = 0;
+
+    // Reflects every active uniform via glGetActiveUniform into the lookup tables
+    // and attaches known uniform blocks to their binding points
+    void reflect();
+
+    GLint location(UniformID uniform) const {
+        return m_locations[static_cast<size_t>(uniform)];
+    }
+
+    // Any active uniform by its full name, e.g. "uColors[2]"
+    GLint location(const std::string& name) const {
+        auto it = m_named.find(name);
+        return it != m_named.end() ? it->second : -1;
+    }
+
+private:
+    std::array<GLint, static_cast<size_t>(UniformID::Count)> m_locations{};
+    std::unordered_map<std::string, GLint> m_named;
+};
+
+#endif // SHADERPROGRAM_H
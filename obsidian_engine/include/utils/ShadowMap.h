@@ -0,0 +1,87 @@
+#ifndef SHADOW_MAP_H
+#define SHADOW_MAP_H
+
+#include "LightSource.h"
+#include "ShaderProgram.h"
+#include "SpatialGrid.h"
+#include "StreamBuffer.h"
+#include "../includes.h"
+
+class Shape;
+
+// 1D polar shadow maps for point lights, packed as rows of one depth texture.
+// Texel x of a light's row holds the distance (as a fraction of the radius)
+// to the nearest shadow casting edge in direction -pi + 2pi * (x + 0.5) / resolution.
+//
+// Edges of caster shapes are drawn as quads spanning their angular range and
+// the fragment shader writes the exact ray/edge distance as depth, so the
+// depth test keeps the nearest edge. A row is only redrawn when its light
+// moves or a caster inside the light's radius changes.
+class ShadowMap {
+public:
+    ShadowMap() = default;
+    ~ShadowMap();
+
+    ShadowMap(const ShadowMap&) = delete;
+    ShadowMap& operator=(const ShadowMap&) = delete;
+
+    void destroy();
+
+    // Angular texels per light; every row is redrawn on the next update
+    void setResolution(int texels);
+    int getResolution() const { return m_resolution; }
+
+    // Assigns rows to the shadow casting point lights among the first
+    // `count` lights and redraws the rows that went stale. `program` is the
+    // built-in "shadow" program. Returns the number of rows redrawn.
+    int update(const std::vector<std::shared_ptr<LightSource>>& lights, size_t count,
+               SpatialGrid& grid, StreamBuffer& stream, const ShaderProgram& program);
+
+    // Texture v coordinate of the light's row, or -1 if it has none
+    float rowCoord(const LightSource& light) const;
+
+    GLuint texture() const { return m_texture; }
+
+private:
+    struct Row {
+        int row = -1;            // -1 while the texture has no room for it
+        uint64_t signature = 0;  // Light position, radius and casters it was drawn with
+        bool drawn = false;
+        uint32_t frame = 0;      // Last update() that saw the light
+    };
+
+    struct EdgeVertex {
+        glm::vec2 position;  // x = angle / pi, y = row in clip space
+        glm::vec4 segment;   // Edge endpoints relative to the light, divided by its radius
+    };
+
+    static bool casts(const LightSource& light);
+    uint64_t signature(const LightSource& light, const std::vector<Shape*>& casters) const;
+
+    void allocate(int rows);
+    void appendCasters(int row, const LightSource& light, const std::vector<Shape*>& casters);
+    void appendEdge(int row, const LightSource& light, const glm::vec2& from, const glm::vec2& to);
+    void appendQuad(int row, float angleMin, float angleMax, const glm::vec4& segment);
+    void draw(StreamBuffer& stream, const ShaderProgram& program);
+
+    int m_resolution = 1024;
+    int m_capacity = 0;  // Rows in the texture
+    GLuint m_texture = 0;
+    GLuint m_fbo = 0;
+    GLuint m_vao = 0;
+
+    std::unordered_map<const LightSource*, Row> m_rows;
+    std::vector<int> m_freeRows;
+    int m_usedRows = 0;  // Rows handed out so far, free or not
+    int m_maxRows = 0;   // GL_MAX_TEXTURE_SIZE
+    uint32_t m_frame = 0;
+
+    // Scratch reused across updates
+    std::vector<Shape*> m_casters;
+    std::vector<glm::vec2> m_points;
+    std::vector<std::pair<GLuint, GLuint>> m_edges;
+    std::vector<EdgeVertex> m_vertices;
+    std::vector<int> m_dirtyRows;
+};
+
+#endif // SHADOW_MAP_H
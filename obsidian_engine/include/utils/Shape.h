@@ -2,7 +2,15 @@
 #define SHAPE_H
 
 #include "Texture.h"
+#include "TextureAtlas.h"
 #include "Vertex.h"
+#include "AABB.h"
+#include "SlotMap.h"
+#include "ShaderProgram.h"
+#include "MeshRegistry.h"
+
+class SpatialGrid;
+class Graphics;
 
 
 enum class PrimitiveType {
@@ -14,35 +22,128 @@ enum class PrimitiveType {
 };
 
 class Shape {
+    friend class SpatialGrid;
+    friend class RenderQueue;
+    friend class Graphics;
+    friend class ShadowMap;
+    friend class TextMesh;
+
 public:
     std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;  // Optional; when set the shape is drawn with glDrawElements
     PrimitiveType type = PrimitiveType::Triangles;
     std::string shaderName = "default";
-    GLuint vao = 0;
-    GLuint vbo = 0;
     Texture texture = Texture(0);
-    glm::mat4 modelMatrix = glm::mat4(1.0f);
+    glm::vec4 tint = glm::vec4(1.0f);                      // Multiplied with the vertex colors
+    glm::vec4 uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);  // Texture sub-rect: xy = offset, zw = size
     bool isVisible = true;
     GLuint queryID = 0;  // For occlusion queries
     float depth = 0;
+    // Set for geometry rewritten every frame: the vertices are streamed through
+    // Graphics' ring buffer at draw time and updateBuffers() is never needed
+    bool dynamic = false;
+    // Blocks shadow casting point lights (see LightSource::castsShadows)
+    bool castsShadow = false;
 
     Shape(const std::vector<Vertex>& verts, Texture tex, PrimitiveType primType = PrimitiveType::Triangles);
+    Shape(const std::vector<Vertex>& verts, const std::vector<GLuint>& indices, Texture tex,
+          PrimitiveType primType = PrimitiveType::Triangles);
 
+    // Re-uploads `vertices` and `indices` after they were edited directly and
+    // refreshes the bounds. Transforms never need this, they only touch the model matrix.
     void updateBuffers();
-    void draw(const glm::mat4& view, const glm::mat4& projection, GLuint shaderProgram);
+
+    // Layout of the GPU copy of `vertices`; changing it re-uploads the buffer
+    void setVertexFormat(VertexFormat format);
+    VertexFormat getVertexFormat() const { return m_format; }
+    GLenum drawMode() const;
+    // Expects shaderProgram to be bound already (Graphics tracks the current program)
+    void draw(const glm::mat4& view, const glm::mat4& projection, const ShaderProgram& shaderProgram);
+    // Per-shape uniforms and texture used by draw(), for callers supplying the vertices themselves
+    void applyUniforms(const glm::mat4& view, const glm::mat4& projection, const ShaderProgram& shaderProgram) const;
 
     void initQuery();
     void deleteQuery();
-    void drawOcclusionQuery(const glm::mat4& view, const glm::mat4& projection, GLuint shaderProgram);
+    void drawOcclusionQuery(const glm::mat4& view, const glm::mat4& projection, const ShaderProgram& shaderProgram);
 
+    // Atlas regions set both the page texture and the sub-rect UVs
+    void setTexture(const Texture& texture, const glm::vec4& uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+    void setTexture(const AtlasRegion& region);
+
+    // Transforms update position/rotation/scale; the vertex data stays untouched
     void translate(const glm::vec2& offset);
     void rotate(float degrees, const glm::vec2& origin = glm::vec2(0.0f));
+    // Non-uniform factors are applied in the shape's local (rotated) space
     void scale(const glm::vec2& factors, const glm::vec2& origin = glm::vec2(0.0f));
 
-    // Factory functions
+    void setPosition(const glm::vec2& position);
+    void setRotation(float degrees);
+    void setScale(const glm::vec2& scale);
+
+    const glm::vec2& getPosition() const { return m_position; }
+    float getRotation() const { return m_rotation; }
+    const glm::vec2& getScale() const { return m_scale; }
+
+    // translate(position) * rotate(rotation) * scale(scale), rebuilt lazily when dirty
+    const glm::mat4& getModelMatrix() const;
+
+    // Bounds of `vertices`, and of the transformed vertices in world space.
+    // Both are cached and only recomputed after a transform or updateBuffers().
+    const AABB& getLocalBounds() const;
+    const AABB& getWorldBounds() const;
+
+    // Returns a new shape drawing the same GPU geometry (VAO/VBO) with its own
+    // transform. Shapes that share geometry are drawn instanced by Graphics.
+    // The geometry is freed with the last shape sharing it.
+    std::shared_ptr<Shape> share() const;
+
+    GLuint getVAO() const { return m_mesh->vao; }
+
+    // Factory functions. Rectangles and circles are indexed triangle lists so
+    // the batcher can merge them without duplicating vertices.
     static std::shared_ptr<Shape> createRectangle(float width = 1.0f, float height = 1.0f);
     static std::shared_ptr<Shape> createTriangle(const glm::vec2& p1, const glm::vec2& p2, const glm::vec2& p3);
     static std::shared_ptr<Shape> createCircle(float radius = 1.0f, int segments = 32);
+
+private:
+    void initBuffers();
+    void uploadVertices();
+    void markTransformed();
+    void markGeometryChanged();
+    void notifyGrid();
+
+    std::shared_ptr<MeshResource> m_mesh;
+    VertexFormat m_format = VertexFormat::Float;
+
+    glm::vec2 m_position = glm::vec2(0.0f);
+    float m_rotation = 0.0f;  // Degrees
+    glm::vec2 m_scale = glm::vec2(1.0f);
+
+    mutable glm::mat4 m_modelMatrix = glm::mat4(1.0f);
+    mutable bool m_modelDirty = false;
+
+    mutable AABB m_localBounds;
+    mutable AABB m_worldBounds;
+    mutable bool m_localBoundsDirty = true;
+    mutable bool m_worldBoundsDirty = true;
+
+    // Spatial index this shape reports its moves to (see SpatialGrid)
+    SpatialGrid* m_grid = nullptr;
+    uint32_t m_gridEntry = 0;
+    bool m_gridMoved = false;
+
+    // Bumped on every transform or geometry change, lets shadow maps detect moved casters
+    uint32_t m_revision = 0;
+
+    // Handle in the Graphics that currently renders this shape
+    SlotHandle m_handle;
+
+    // Set by TextMesh, which Graphics refreshes before drawing
+    bool m_isText = false;
+
+    // RenderQueue bookkeeping
+    uint64_t m_renderOrder = 0;
+    uint32_t m_queueFrame = 0;
 };
 
 #endif // SHAPE_H
\ No newline at end of file
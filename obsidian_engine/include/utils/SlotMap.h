@@ -0,0 +1,153 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <limits>
+#include "../includes.h"
+
+// Stable reference into a SlotMap. A handle goes stale when its element is
+// removed; the generation check catches reuse of the slot by a later insert.
+struct SlotHandle {
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    uint32_t index = npos;
+    uint32_t generation = 0;
+
+    bool valid() const { return index != npos; }
+    bool operator==(const SlotHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+// Generational slot map: O(1) insert, remove and lookup by handle, with the
+// elements themselves kept densely packed (removal swaps the last element
+// into the hole), so iteration never visits dead entries. Freed slots are
+// reused through a free list.
+template <typename T>
+class SlotMap {
+public:
+    SlotHandle insert(T value) {
+        uint32_t slot;
+        if (m_freeHead != SlotHandle::npos) {
+            slot = m_freeHead;
+            m_freeHead = m_slots[slot].nextFree;
+        } else {
+            slot = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back({ 0, m_generationFloor, SlotHandle::npos });
+        }
+
+        m_slots[slot].dense = static_cast<uint32_t>(m_dense.size());
+        m_dense.push_back(std::move(value));
+        m_denseToSlot.push_back(slot);
+
+        return { slot, m_slots[slot].generation };
+    }
+
+    bool remove(SlotHandle handle) {
+        if (!contains(handle)) return false;
+
+        Slot& removed = m_slots[handle.index];
+        uint32_t hole = removed.dense;
+        uint32_t last = static_cast<uint32_t>(m_dense.size() - 1);
+
+        if (hole != last) {
+            m_dense[hole] = std::move(m_dense[last]);
+            m_denseToSlot[hole] = m_denseToSlot[last];
+            m_slots[m_denseToSlot[hole]].dense = hole;
+        }
+        m_dense.pop_back();
+        m_denseToSlot.pop_back();
+
+        // Invalidates every outstanding handle to this slot
+        removed.dense = SlotHandle::npos;
+        removed.generation++;
+        removed.nextFree = m_freeHead;
+        m_freeHead = handle.index;
+        return true;
+    }
+
+    bool contains(SlotHandle handle) const {
+        return handle.index < m_slots.size()
+            && m_slots[handle.index].generation == handle.generation
+            && m_slots[handle.index].dense < m_dense.size()
+            && m_denseToSlot[m_slots[handle.index].dense] == handle.index;
+    }
+
+    T* get(SlotHandle handle) {
+        return contains(handle) ? &m_dense[m_slots[handle.index].dense] : nullptr;
+    }
+
+    const T* get(SlotHandle handle) const {
+        return contains(handle) ? &m_dense[m_slots[handle.index].dense] : nullptr;
+    }
+
+    void clear() {
+        // Bump generations so handles from before the clear stay invalid
+        for (uint32_t slot : m_denseToSlot) {
+            m_slots[slot].generation++;
+        }
+        m_dense.clear();
+        m_denseToSlot.clear();
+        rebuildFreeList();
+    }
+
+    // Returns memory after mass removals: trailing free slots are dropped and
+    // the dense arrays shrunk. Slots that are recreated later start above any
+    // generation a dropped slot reached, so old handles still never match.
+    void compact() {
+        std::vector<bool> used(m_slots.size(), false);
+        for (uint32_t slot : m_denseToSlot) used[slot] = true;
+
+        while (!m_slots.empty() && !used[m_slots.size() - 1]) {
+            m_generationFloor = std::max(m_generationFloor, m_slots.back().generation + 1);
+            m_slots.pop_back();
+        }
+
+        m_slots.shrink_to_fit();
+        m_dense.shrink_to_fit();
+        m_denseToSlot.shrink_to_fit();
+        rebuildFreeList();
+    }
+
+    size_t size() const { return m_dense.size(); }
+    bool empty() const { return m_dense.empty(); }
+    size_t slotCount() const { return m_slots.size(); }
+
+    // Handle of the element at a dense position, e.g. while iterating
+    SlotHandle handleAt(size_t position) const {
+        uint32_t slot = m_denseToSlot[position];
+        return { slot, m_slots[slot].generation };
+    }
+
+    typename std::vector<T>::iterator begin() { return m_dense.begin(); }
+    typename std::vector<T>::iterator end() { return m_dense.end(); }
+    typename std::vector<T>::const_iterator begin() const { return m_dense.begin(); }
+    typename std::vector<T>::const_iterator end() const { return m_dense.end(); }
+
+private:
+    struct Slot {
+        uint32_t dense;       // Position in m_dense while alive
+        uint32_t generation;
+        uint32_t nextFree;    // Free list link while dead
+    };
+
+    void rebuildFreeList() {
+        std::vector<bool> used(m_slots.size(), false);
+        for (uint32_t slot : m_denseToSlot) used[slot] = true;
+
+        // Lowest slots first, so reuse keeps the slot array short
+        m_freeHead = SlotHandle::npos;
+        for (size_t i = m_slots.size(); i-- > 0;) {
+            if (used[i]) continue;
+            m_slots[i].dense = SlotHandle::npos;
+            m_slots[i].nextFree = m_freeHead;
+            m_freeHead = static_cast<uint32_t>(i);
+        }
+    }
+
+    std::vector<T> m_dense;
+    std::vector<uint32_t> m_denseToSlot;
+    std::vector<Slot> m_slots;
+    uint32_t m_freeHead = SlotHandle::npos;
+    uint32_t m_generationFloor = 0;
+};
+
+#endif // SLOT_MAP_H
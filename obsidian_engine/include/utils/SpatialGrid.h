@@ -0,0 +1,73 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include "AABB.h"
+#include "../includes.h"
+
+class Shape;
+
+// Uniform grid over shape world bounds, used by Graphics to find the shapes
+// that intersect the camera rectangle. Shapes report their own transform and
+// geometry changes, so only moved shapes are re-bucketed and a query costs
+// O(visible) rather than O(world).
+//
+// Shapes covering many cells and dynamic shapes (whose vertices change
+// without notice) are kept in a list that every query returns.
+class SpatialGrid {
+    friend class Shape;
+
+public:
+    explicit SpatialGrid(float cellSize = 256.0f);
+    ~SpatialGrid();
+
+    SpatialGrid(const SpatialGrid&) = delete;
+    SpatialGrid& operator=(const SpatialGrid&) = delete;
+
+    // Re-buckets everything
+    void setCellSize(float cellSize);
+    float getCellSize() const { return m_cellSize; }
+
+    void insert(Shape* shape);
+    void remove(Shape* shape);
+    void clear();
+    size_t size() const { return m_entries.size(); }
+
+    // Appends the shapes whose bounds intersect `area`, in insertion order
+    void query(const AABB& area, std::vector<Shape*>& out);
+
+private:
+    struct Entry {
+        Shape* shape = nullptr;
+        uint64_t order = 0;
+        glm::ivec2 cellMin = glm::ivec2(0);
+        glm::ivec2 cellMax = glm::ivec2(-1);  // Empty range while not bucketed
+        std::vector<uint32_t> cellPos;  // Position in each covered cell's list, row by row
+        uint32_t alwaysPos = 0;         // Position in m_always
+        bool always = false;
+        uint32_t stamp = 0;  // Last query that reported this entry
+    };
+
+    // Cells a shape may span before it moves to the always-tested list
+    static constexpr int maxCellsPerShape = 64;
+
+    static uint64_t cellKey(int x, int y);
+    glm::ivec2 cellOf(const glm::vec2& point) const;
+
+    void markMoved(Shape* shape);
+    void update();
+    void bucket(uint32_t index);
+    void unbucket(uint32_t index);
+    // Slot in entry.cellPos for a cell inside its range
+    static uint32_t& cellSlot(Entry& entry, int x, int y);
+
+    float m_cellSize;
+    uint64_t m_nextOrder = 0;
+    uint32_t m_stamp = 0;
+
+    std::vector<Entry> m_entries;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;  // Entry indices per cell
+    std::vector<uint32_t> m_always;
+    std::vector<uint32_t> m_moved;
+};
+
+#endif // SPATIAL_GRID_H
@@ -0,0 +1,76 @@
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include "Shape.h"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+#include "../includes.h"
+
+// Merges consecutive shapes that share a shader, texture and primitive mode
+// into one draw call. Model transforms are applied on the CPU and the
+// vertices are written into a StreamBuffer shared with other per-frame data.
+//
+// Triangles and lines are merged as indexed lists, so every shape vertex is
+// streamed once. Runs made only of quads use a shared static index buffer
+// and stream no indices at all.
+class SpriteBatch {
+public:
+    // Quads one draw can cover with the shared 16-bit quad index buffer
+    static constexpr size_t maxQuads = 16384;
+
+    SpriteBatch() = default;
+    ~SpriteBatch();
+
+    void initialize(StreamBuffer& stream);
+    void destroy();
+
+    // Layout vertices are streamed in; the batch must be empty
+    void setFormat(VertexFormat format);
+    VertexFormat getFormat() const { return m_format; }
+
+    // Maps a shape primitive to the mode it is drawn with inside a batch.
+    // Fans and strips are expanded to triangle lists so they can be merged.
+    static GLenum batchMode(PrimitiveType type);
+
+    bool empty() const { return m_vertices.empty(); }
+    bool accepts(const ShaderProgram* program, GLuint texture, GLenum mode) const;
+
+    void begin(const ShaderProgram* program, GLuint texture, GLenum mode);
+    void append(Shape& shape);
+
+    // Uploads the collected vertices and issues the draw call. The caller is
+    // responsible for binding the program and getTexture() and for setting
+    // the uniforms first.
+    // Returns the number of vertices submitted.
+    int flush();
+
+    // Streams a shape's local-space vertices (and indices) and draws them with
+    // the shape's own primitive mode. Uniforms are the caller's job as well.
+    void drawShape(const Shape& shape);
+
+    const ShaderProgram* getProgram() const { return m_program; }
+    GLuint getTexture() const { return m_texture; }
+
+private:
+    void bindAttributes();
+    GLint streamVertices(const Vertex* vertices, size_t count);
+    size_t streamIndices(const GLuint* indices, size_t count);
+
+    std::vector<Vertex> m_vertices;
+    std::vector<PackedVertex> m_packed;  // Conversion scratch for VertexFormat::Packed
+    std::vector<GLuint> m_indices;       // Relative to the first vertex of the batch
+    std::vector<GLuint> m_localIndices;
+    bool m_allQuads = true;
+
+    GLuint m_vao = 0;
+    GLuint m_quadIBO = 0;
+    VertexFormat m_format = VertexFormat::Float;
+    StreamBuffer* m_stream = nullptr;
+    unsigned m_streamGeneration = 0;  // Generation the attribute pointers refer to
+
+    const ShaderProgram* m_program = nullptr;
+    GLuint m_texture = 0;
+    GLenum m_mode = GL_TRIANGLES;
+};
+
+#endif // SPRITEBATCH_H
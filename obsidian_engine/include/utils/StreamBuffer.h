@@ -0,0 +1,75 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <array>
+#include <cstring>
+#include "../includes.h"
+
+struct StreamStats {
+    size_t bytes = 0;  // Written since beginFrame()
+    int stalls = 0;    // Times beginFrame() had to wait for the GPU to release a region
+    int resizes = 0;   // Times the buffer was recreated larger because a frame did not fit
+};
+
+// Ring of per-frame regions in one GL buffer for data rewritten every frame
+// (batched vertices, instance attributes, dynamic shapes). Each region is
+// fenced when its frame ends and only reused once the GPU is done with it,
+// so writes never need orphaning or implicit syncs.
+//
+// With GL 4.4 the buffer is persistently mapped; otherwise every write maps
+// its range with GL_MAP_UNSYNCHRONIZED_BIT, which is safe thanks to the fences.
+class StreamBuffer {
+public:
+    static constexpr int Regions = 3;
+
+    StreamBuffer() = default;
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    void initialize(GLenum target, size_t regionBytes);
+    void destroy();
+
+    // Moves to the next region, waiting for its fence if the GPU still reads it
+    void beginFrame();
+    // Fences the current region
+    void endFrame();
+
+    // Copies data into the current region and returns its byte offset in the
+    // buffer. The offset is a multiple of alignment so it can double as a
+    // vertex index (alignment = vertex stride). Leaves the buffer bound to the target.
+    size_t write(const void* data, size_t bytes, size_t alignment = 4);
+
+    // Grows the buffer up front if the next `bytes` (alignment padding
+    // included) would not fit, so writes that refer to each other, like
+    // vertices and their indices, are guaranteed to share one generation
+    void reserve(size_t bytes);
+
+    GLuint id() const { return m_buffer; }
+    bool persistent() const { return m_mapped != nullptr; }
+
+    // Bumped whenever the buffer is recreated; attribute pointers set up
+    // against an older generation must be specified again
+    unsigned generation() const { return m_generation; }
+
+    const StreamStats& stats() const { return m_stats; }
+
+private:
+    void allocate(size_t regionBytes);
+    void release();
+
+    GLenum m_target = GL_ARRAY_BUFFER;
+    GLuint m_buffer = 0;
+    unsigned char* m_mapped = nullptr;  // Persistent mapping, if supported
+    size_t m_regionBytes = 0;
+
+    std::array<GLsync, Regions> m_fences{};
+    int m_region = 0;
+    size_t m_head = 0;  // Offset inside the current region
+    unsigned m_generation = 0;
+
+    StreamStats m_stats;
+};
+
+#endif // STREAM_BUFFER_H
@@ -0,0 +1,56 @@
+#ifndef TEXT_MESH_H
+#define TEXT_MESH_H
+
+#include "Shape.h"
+#include "Font.h"
+#include "../includes.h"
+
+// Static text laid out once into the shape's own vertex and index buffers.
+// Quads are built in font pixels with the first baseline at the origin, so
+// position, rotation, scale and color (the tint) are plain shape transforms
+// and never trigger a rebuild; only the string, font or wrap width do.
+//
+// Added to Graphics like any other shape, it is depth sorted, culled, lit
+// and batched with shapes that share its font. The font must outlive the mesh.
+class TextMesh : public Shape {
+public:
+    // Same parameters as Graphics::renderText
+    static std::shared_ptr<TextMesh> create(Font& font, const std::string& text,
+                                            const glm::vec2& position = glm::vec2(0.0f), float scale = 1.0f,
+                                            glm::vec3 color = glm::vec3(1.0f), float rotationDegrees = 0.0f);
+
+    explicit TextMesh(Font& font, const std::string& text = "");
+
+    void setText(const std::string& text);
+    const std::string& getText() const { return m_text; }
+
+    void setFont(Font& font);
+    Font& getFont() const { return *m_font; }
+
+    // Lines are broken at spaces (or inside words longer than a line) so they
+    // fit this width in font pixels, i.e. before the shape's scale. 0 = only at '\n'.
+    void setWrapWidth(float width);
+    float getWrapWidth() const { return m_wrapWidth; }
+
+    // Width of the widest line and total height in font pixels
+    const glm::vec2& getSize() const { return m_size; }
+
+    // Relayouts if the font was reloaded and adjusts the UVs if its atlas grew.
+    // Graphics calls this for visible meshes before drawing them; returns the
+    // bytes uploaded to the font atlas.
+    size_t refresh();
+
+private:
+    size_t rebuild();
+
+    Font* m_font;
+    std::string m_text;
+    float m_wrapWidth = 0.0f;
+    glm::vec2 m_size{ 0.0f };
+
+    std::vector<uint32_t> m_codepoints;  // Layout scratch
+    uint32_t m_fontRevision = 0;          // Font::revision() the quads were built from
+    int m_atlasHeight = 0;                // Atlas height the UVs are normalized to
+};
+
+#endif // TEXT_MESH_H
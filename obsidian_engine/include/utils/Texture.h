@@ -7,14 +7,34 @@
 
 #include "../includes.h"
 
+struct TextureResource;
+
+// Handle to a GL texture. Handles created from a path or pixels share one
+// ref-counted TextureResource; the GPU texture is freed with the last handle.
+// Texture(GLuint) wraps a raw id without taking ownership.
 class Texture {
+    friend class TextureRegistry;
+    friend class TextureLoader;
+
     GLuint texture = 0;
+    std::shared_ptr<TextureResource> m_resource;
+
+    explicit Texture(std::shared_ptr<TextureResource> resource);
 public:
 
     Texture(const std::string& path, GLint filtering);
     Texture(GLuint texture);
 
-    GLuint getData();
+    // Shared 1x1 white texture of the active registry
+    static Texture white();
+
+    // Uploads RGBA8 pixels, reusing an existing texture with identical content
+    static Texture fromPixels(int width, int height, const unsigned char* rgba, GLint filtering = GL_NEAREST);
+
+    // Allocates an uninitialized RGBA8 texture that is never deduplicated (render targets, atlas pages)
+    static Texture create(int width, int height, GLint filtering = GL_NEAREST);
+
+    GLuint getData() const;
 };
 
 #endif //TEXTURE_H
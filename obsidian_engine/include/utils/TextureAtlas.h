@@ -0,0 +1,62 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <limits>
+#include "Texture.h"
+#include "../includes.h"
+
+// Location of one packed image inside an atlas page
+struct AtlasRegion {
+    Texture texture = Texture(0);                          // Page the image lives on
+    glm::vec4 uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);  // xy = offset, zw = size, in page UVs
+    int width = 0;
+    int height = 0;
+
+    bool valid() const { return texture.getData() != 0; }
+};
+
+// Packs images into large RGBA pages with a skyline bottom-left packer so
+// many sprites can share one texture (and therefore one batch or instanced draw).
+// Every image gets `padding` pixels of border on each side; with `extrude` the
+// border repeats the image's edge pixels so GL_LINEAR / GL_NEAREST sampling at
+// the sub-rect edge never picks up a neighbour.
+class TextureAtlas {
+public:
+    explicit TextureAtlas(int pageSize = 2048, int padding = 2, bool extrude = true, GLint filtering = GL_NEAREST);
+
+    // Loads an image with stb_image (flipped like Texture) and packs it.
+    // Adding the same name twice returns the existing region.
+    AtlasRegion add(const std::string& path);
+    AtlasRegion add(const std::string& name, int width, int height, const unsigned char* rgba);
+
+    AtlasRegion find(const std::string& name) const;
+
+    size_t pageCount() const { return m_pages.size(); }
+    int getPageSize() const { return m_pageSize; }
+
+private:
+    struct SkylineNode {
+        int x;
+        int y;
+        int width;
+    };
+
+    struct Page {
+        Texture texture = Texture(0);
+        std::vector<SkylineNode> skyline;
+    };
+
+    bool place(Page& page, int width, int height, int& outX, int& outY);
+    int fit(const Page& page, size_t index, int width, int height) const;
+    Page& addPage();
+
+    int m_pageSize;
+    int m_padding;
+    bool m_extrude;
+    GLint m_filtering;
+
+    std::vector<Page> m_pages;
+    std::unordered_map<std::string, AtlasRegion> m_regions;
+};
+
+#endif // TEXTURE_ATLAS_H
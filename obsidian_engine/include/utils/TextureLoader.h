@@ -0,0 +1,120 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include "Texture.h"
+#include "../includes.h"
+
+class TextureRegistry;
+struct TextureResource;
+
+// Called on the GL thread once a texture finished loading. On failure the
+// handle keeps showing the placeholder.
+using TextureReadyCallback = std::function<void(const Texture& texture, bool loaded)>;
+
+struct TextureLoadProgress {
+    size_t requested = 0;
+    size_t completed = 0;      // Uploaded or failed
+    size_t failed = 0;
+    size_t bytesUploaded = 0;
+
+    float fraction() const {
+        return requested ? static_cast<float>(completed) / static_cast<float>(requested) : 1.0f;
+    }
+};
+
+// Decodes images on a pool of worker threads and uploads them on the GL
+// thread through a pixel unpack buffer, a strip of rows at a time, so a
+// large image is spread over several frames instead of stalling one.
+// Handles returned by load() show the registry's white texture until their
+// upload completes.
+class TextureLoader {
+public:
+    TextureLoader() = default;
+    ~TextureLoader();
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // workerCount 0 picks one less than the hardware concurrency
+    void initialize(TextureRegistry& registry, unsigned workerCount = 0);
+    void shutdown();  // Joins the workers; GL context must still be current
+
+    Texture load(const std::string& path, GLint filtering = GL_LINEAR, TextureReadyCallback onReady = nullptr);
+
+    // Becomes ready during update(), so never wait on it from the GL thread
+    std::shared_future<Texture> loadFuture(const std::string& path, GLint filtering = GL_LINEAR);
+
+    // GL thread. Uploads decoded images until budgetMs is spent, always making
+    // some progress. Returns the number of textures completed.
+    int update(double budgetMs);
+
+    // GL thread. Blocks until every queued texture is decoded and uploaded.
+    void finish();
+
+    TextureLoadProgress progress() const;
+    bool busy() const { return !m_pending.empty(); }
+
+    // Bytes copied per glTexSubImage2D strip (default 1 MiB)
+    void setStripSize(size_t bytes) { m_stripBytes = std::max<size_t>(bytes, 1); }
+
+private:
+    struct DecodeJob {
+        std::string key;
+        std::string path;
+    };
+
+    struct DecodeResult {
+        std::string key;
+        unsigned char* pixels = nullptr;
+        int width = 0;
+        int height = 0;
+    };
+
+    // GL-thread bookkeeping for one requested texture
+    struct Pending {
+        std::shared_ptr<TextureResource> resource;
+        GLint filtering = GL_LINEAR;
+        std::vector<TextureReadyCallback> callbacks;
+        std::shared_ptr<std::promise<Texture>> promise;
+        std::shared_future<Texture> future;
+    };
+
+    // Image currently being streamed into its texture
+    struct Upload {
+        DecodeResult image;
+        GLuint texture = 0;
+        int rowsDone = 0;
+    };
+
+    Texture request(const std::string& path, GLint filtering, Pending*& pending);
+    void workerLoop();
+    bool beginUpload();
+    bool uploadStrip();
+    void complete(const std::string& key, GLuint texture);
+
+    TextureRegistry* m_registry = nullptr;
+
+    std::vector<std::thread> m_workers;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_decodedSignal;
+    std::deque<DecodeJob> m_decodeQueue;
+    std::deque<DecodeResult> m_decoded;
+    bool m_stopping = false;
+
+    std::unordered_map<std::string, Pending> m_pending;
+    Upload m_upload;
+    bool m_uploading = false;
+    GLuint m_pbo = 0;
+    size_t m_stripBytes = 1 << 20;
+
+    TextureLoadProgress m_progress;
+};
+
+#endif // TEXTURE_LOADER_H
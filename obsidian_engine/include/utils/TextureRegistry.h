@@ -0,0 +1,80 @@
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <mutex>
+#include "Texture.h"
+#include "../includes.h"
+
+struct TextureResource;
+
+struct TextureRegistryState {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::weak_ptr<TextureResource>> entries;
+    std::vector<GLuint> textures;  // Released ids waiting for TextureRegistry::collect()
+    bool contextAlive = true;
+};
+
+// Shared GPU texture behind one or more Texture handles
+struct TextureResource {
+    GLuint id = 0;
+    std::string key;
+    // Empty for unregistered textures. Shared so a handle outliving the
+    // registry still sees contextAlive == false and leaves GL alone.
+    std::shared_ptr<TextureRegistryState> registry;
+    bool placeholder = false;  // id is borrowed (white texture) until an async load completes
+    std::vector<unsigned char> pixels;  // fromPixels content, compared when a content hash matches
+
+    ~TextureResource();
+};
+
+// Deduplicates textures by source path or pixel content and hands out
+// ref-counted Texture handles. Owned by Graphics; while initialized it is the
+// registry used by Texture constructors and Shape factories.
+// Like meshes, handles may be dropped off the GL thread, so registered
+// textures are only queued on release and deleted by collect().
+class TextureRegistry {
+public:
+    TextureRegistry() = default;
+    ~TextureRegistry();
+
+    TextureRegistry(const TextureRegistry&) = delete;
+    TextureRegistry& operator=(const TextureRegistry&) = delete;
+
+    static TextureRegistry* active();
+
+    void initialize();  // Creates the shared white texture and becomes active
+    void shutdown();    // Releases the registry's own handles; GL context must still be current
+
+    // Deletes the textures released since the last call, returns how many went
+    size_t collect();
+
+    Texture load(const std::string& path, GLint filtering);
+    Texture fromPixels(int width, int height, const unsigned char* rgba, GLint filtering);
+    Texture create(int width, int height, GLint filtering);
+    Texture white() const { return m_white; }
+
+    // Registered texture for a key, or an empty handle
+    Texture find(const std::string& key) const;
+
+    // Registers a handle for key that shows the white texture until its
+    // resource id is replaced (used by TextureLoader)
+    Texture reserve(const std::string& key);
+
+    static std::string fileKey(const std::string& path, GLint filtering);
+
+    size_t liveTextures() const;
+
+    // Decodes a file and uploads it without registering it anywhere
+    static Texture loadUnregistered(const std::string& path, GLint filtering);
+    static GLuint upload(int width, int height, const unsigned char* rgba, GLint filtering, bool mipmaps);
+
+private:
+    Texture adopt(GLuint id, const std::string& key);
+
+    std::shared_ptr<TextureRegistryState> m_state;
+    std::vector<GLuint> m_released;  // Scratch for collect(), swapped with the pending list
+    uint64_t m_uniqueCounter = 0;
+    Texture m_white = Texture(0);
+};
+
+#endif // TEXTURE_REGISTRY_H
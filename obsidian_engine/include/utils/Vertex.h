@@ -14,5 +14,51 @@ struct Vertex {
         : position(position), color(color), uv(uv) {}
 };
 
-#endif //VERTEX_H
+// 16 byte GPU layout: color as normalized uint8x4, uv as normalized uint16x2.
+// Colors and UVs are clamped to [0, 1]; anything outside needs VertexFormat::Float.
+struct PackedVertex {
+    glm::vec2 position;
+    uint8_t color[4];
+    uint16_t uv[2];
+
+    PackedVertex() = default;
+    PackedVertex(const Vertex& v) : position(v.position) {
+        for (int i = 0; i < 4; ++i) {
+            color[i] = static_cast<uint8_t>(glm::clamp(v.color[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+        for (int i = 0; i < 2; ++i) {
+            uv[i] = static_cast<uint16_t>(glm::clamp(v.uv[i], 0.0f, 1.0f) * 65535.0f + 0.5f);
+        }
+    }
+};
+
+enum class VertexFormat {
+    Float,   // Vertex, 32 bytes
+    Packed   // PackedVertex, 16 bytes
+};
 
+inline size_t vertexStride(VertexFormat format) {
+    return format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+// Points attributes 0..2 (position, color, uv) at the buffer bound to
+// GL_ARRAY_BUFFER. Shaders read the same vec2/vec4/vec2 in both formats.
+inline void setVertexAttributes(VertexFormat format) {
+    GLsizei stride = static_cast<GLsizei>(vertexStride(format));
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+
+    if (format == VertexFormat::Packed) {
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, position));
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(PackedVertex, color));
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, uv));
+    } else {
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, position));
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, color));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, uv));
+    }
+}
+
+#endif //VERTEX_H
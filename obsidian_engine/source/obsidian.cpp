@@ -1,4 +1,7 @@
 #include "../include/obsidian.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 
 Obsidian::Obsidian(int width, int height, const char *title)
     : m_width(width), m_height(height), m_title(title), m_window(nullptr), m_graphics() {
@@ -7,17 +10,33 @@ Obsidian::Obsidian(int width, int height, const char *title)
 Obsidian::~Obsidian() {
     onDestroy();
     if (m_window) {
+        // Release GL objects while the context still exists
+        glfwMakeContextCurrent(m_window);
+        m_graphics.cleanup();
         glfwDestroyWindow(m_window);
     }
     glfwTerminate();
 }
 
-void Obsidian::run(bool cappedFPS) {
+bool Obsidian::createWindow(bool visible) {
+    if (!visible) {
+        // No display server to talk to: render through a surfaceless EGL context
+        const char* display = std::getenv("DISPLAY");
+        const char* wayland = std::getenv("WAYLAND_DISPLAY");
+        if ((!display || !*display) && (!wayland || !*wayland)) {
+            glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+        }
+    }
+
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW\n";
-        return;
+        return false;
     }
 
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
+    if (glfwGetPlatform() == GLFW_PLATFORM_NULL) {
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+    }
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -30,12 +49,10 @@ void Obsidian::run(bool cappedFPS) {
     m_window = glfwCreateWindow(m_width, m_height, m_title, nullptr, nullptr);
     if (!m_window) {
         std::cerr << "Failed to create GLFW window\n";
-        glfwTerminate();
-        return;
+        return false;
     }
 
     glfwMakeContextCurrent(m_window);
-    glfwSwapInterval(cappedFPS ? 1 : 0); // 👈 disables V-Sync
     glfwSetWindowUserPointer(m_window, this);
     glfwSetFramebufferSizeCallback(m_window, [](GLFWwindow *win, int w, int h) {
         auto *self = static_cast<Obsidian *>(glfwGetWindowUserPointer(win));
@@ -45,8 +62,20 @@ void Obsidian::run(bool cappedFPS) {
 
     if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
         std::cerr << "Failed to initialize GLAD\n";
+        return false;
+    }
+    return true;
+}
+
+void Obsidian::run(bool cappedFPS) {
+    if (!createWindow(true)) {
         return;
     }
+    if (m_threadedRendering) {
+        runThreaded(cappedFPS);
+        return;
+    }
+    glfwSwapInterval(cappedFPS ? 1 : 0); // 👈 disables V-Sync
 
     // Query the actual framebuffer size (important on Retina)
     int fbWidth, fbHeight;
@@ -63,6 +92,8 @@ void Obsidian::run(bool cappedFPS) {
     m_lastTime = Clock::now();
     m_fpsLastReport = Clock::now();
     m_frameCount = 0;
+    m_accumulator = 0.0f;
+    m_alpha = 1.0f;
 
     if (!m_graphics.initialize(*this)) {
         std::cerr << "Failed to initialize graphics\n";
@@ -78,26 +109,35 @@ void Obsidian::run(bool cappedFPS) {
     // std::cout << "GLSL: "       << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
 
 
-    while (!glfwWindowShouldClose(m_window)) {
-        onDraw(m_graphics);
-
-        glfwSwapBuffers(m_window);
-        glfwPollEvents();
+    Profiler& profiler = m_graphics.getProfiler();
 
+    while (!glfwWindowShouldClose(m_window)) {
+        profiler.beginFrame();
 
+        {
+            Profiler::CpuScope scope(profiler, "onDraw");
+            applyRenderCommands();
+            onDrawInterpolated(m_graphics, m_alpha);
+        }
+        {
+            Profiler::CpuScope scope(profiler, "swap");
+            glfwSwapBuffers(m_window);
+        }
 
         auto currentTime = Clock::now();
         std::chrono::duration<float> delta = currentTime - m_lastTime;
         m_lastTime = currentTime;
         float deltaTime = delta.count();
 
-        for (const auto& [key, action] : keyBindings) {
-            if (glfwGetKey(m_window, key) == GLFW_PRESS) {
-                action(deltaTime);  // Execute the lambda
-            }
+        {
+            Profiler::CpuScope scope(profiler, "input");
+            glfwPollEvents();
         }
 
-        onFrameDrawn(deltaTime);
+        {
+            Profiler::CpuScope scope(profiler, "simulate");
+            simulate(deltaTime, true);
+        }
 
         // FPS tracking
         m_frameCount++;
@@ -109,10 +149,281 @@ void Obsidian::run(bool cappedFPS) {
             m_frameCount = 0;
         }
 
+        profiler.endFrame();
+    }
+}
+
+bool Obsidian::runHeadless(const HeadlessOptions& options) {
+    if (!createWindow(false)) {
+        return false;
+    }
+    if (!createOffscreenTarget()) {
+        return false;
+    }
+
+    glViewport(0, 0, m_width, m_height);
+    m_graphics.resize(m_width, m_height);
+
+    if (!m_graphics.initialize(*this)) {
+        std::cerr << "Failed to initialize graphics\n";
+        destroyOffscreenTarget();
+        return false;
+    }
+
+    onCreate(m_graphics);
+
+    Profiler& profiler = m_graphics.getProfiler();
+    std::vector<unsigned char> pixels;
+    std::vector<unsigned char> row;
+    size_t stride = static_cast<size_t>(m_width) * 4;
+
+    m_accumulator = 0.0f;
+    m_alpha = 1.0f;
+
+    auto startTime = Clock::now();
+    for (int frame = 0; frame < options.frames; ++frame) {
+        profiler.beginFrame();
+
+        // onDraw may bind other framebuffers, so rebind ours every frame
+        glBindFramebuffer(GL_FRAMEBUFFER, m_offscreenFBO);
+        glViewport(0, 0, m_width, m_height);
+        {
+            Profiler::CpuScope scope(profiler, "onDraw");
+            applyRenderCommands();
+            onDrawInterpolated(m_graphics, m_alpha);
+        }
+
+        if (options.readback) {
+            Profiler::CpuScope scope(profiler, "readback");
+            pixels.resize(stride * m_height);
+            row.resize(stride);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, m_offscreenFBO);
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+            // GL rows are bottom-up, images are top-down
+            for (int y = 0; y < m_height / 2; ++y) {
+                unsigned char* top = pixels.data() + stride * y;
+                unsigned char* bottom = pixels.data() + stride * (m_height - 1 - y);
+                std::memcpy(row.data(), top, stride);
+                std::memcpy(top, bottom, stride);
+                std::memcpy(bottom, row.data(), stride);
+            }
+            onFrameRead(frame, pixels);
+        } else {
+            // Nothing presents the frame, keep the driver from queueing unboundedly
+            glFlush();
+        }
+
+        {
+            Profiler::CpuScope scope(profiler, "simulate");
+            simulate(options.timestep, false);
+        }
+
+        profiler.endFrame();
+    }
+    glFinish();
+
+    std::chrono::duration<float> elapsed = Clock::now() - startTime;
+    if (options.frames > 0 && elapsed.count() > 0.0f) {
+        onFpsUpdate(options.frames / elapsed.count());
+    }
+
+    destroyOffscreenTarget();
+    return true;
+}
+
+void Obsidian::runThreaded(bool cappedFPS) {
+    // Framebuffer queries and events belong to this thread, GL to the render thread
+    int fbWidth, fbHeight;
+    glfwGetFramebufferSize(m_window, &fbWidth, &fbHeight);
+    m_width = fbWidth;
+    m_height = fbHeight;
+    glfwMakeContextCurrent(nullptr);
+
+    m_submitted = nullptr;
+    m_renderReady = m_renderFailed = m_renderQuit = false;
+    m_recording = 0;
+    m_renderThreadActive = true;
+    std::thread renderThread(&Obsidian::renderThreadMain, this, cappedFPS);
+
+    bool ready;
+    {
+        std::unique_lock<std::mutex> lock(m_renderMutex);
+        m_renderCondition.wait(lock, [this] { return m_renderReady || m_renderFailed; });
+        ready = m_renderReady;
+    }
+
+    m_lastTime = Clock::now();
+    m_fpsLastReport = Clock::now();
+    m_frameCount = 0;
+    m_accumulator = 0.0f;
+    m_alpha = 1.0f;
+
+    // The first frame draws whatever onCreate set up
+    if (ready) submitFrame();
+
+    while (ready && !glfwWindowShouldClose(m_window)) {
+        glfwPollEvents();
+
+        auto currentTime = Clock::now();
+        std::chrono::duration<float> delta = currentTime - m_lastTime;
+        m_lastTime = currentTime;
+
+        // Overlaps with the render thread drawing the previous frame
+        simulate(delta.count(), true);
+        submitFrame();
+
+        m_frameCount++;
+        std::chrono::duration<float> fpsElapsed = currentTime - m_fpsLastReport;
+        if (fpsElapsed.count() >= 1.0f) {
+            onFpsUpdate(m_frameCount / fpsElapsed.count());
+            m_fpsLastReport = currentTime;
+            m_frameCount = 0;
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_renderMutex);
+        m_renderCondition.wait(lock, [this] { return m_submitted == nullptr; });
+        m_renderQuit = true;
+    }
+    m_renderCondition.notify_all();
+    renderThread.join();
+    m_renderThreadActive = false;
+
+    // Back on this thread for cleanup in the destructor
+    glfwMakeContextCurrent(m_window);
+}
+
+void Obsidian::renderThreadMain(bool cappedFPS) {
+    glfwMakeContextCurrent(m_window);
+    glfwSwapInterval(cappedFPS ? 1 : 0);
+    glViewport(0, 0, m_width, m_height);
+    m_graphics.resize(m_width, m_height);
+
+    bool initialized = m_graphics.initialize(*this);
+    if (initialized) {
+        onCreate(m_graphics);
+    } else {
+        std::cerr << "Failed to initialize graphics\n";
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_renderMutex);
+        m_renderReady = initialized;
+        m_renderFailed = !initialized;
+    }
+    m_renderCondition.notify_all();
+
+    Profiler& profiler = m_graphics.getProfiler();
+    while (initialized) {
+        RenderCommandList* list;
+        float alpha;
+        {
+            std::unique_lock<std::mutex> lock(m_renderMutex);
+            m_renderCondition.wait(lock, [this] { return m_submitted || m_renderQuit; });
+            if (!m_submitted) break;
+            list = m_submitted;
+            alpha = m_submittedAlpha;
+        }
+
+        profiler.beginFrame();
+        {
+            Profiler::CpuScope scope(profiler, "onDraw");
+            list->execute(m_graphics, alpha);
+            // Dropping the last reference to a shape, here or on the simulation
+            // thread, only queues its mesh and textures; Graphics deletes them
+            // on this thread when the next frame renders
+            list->clear();
+            onDrawInterpolated(m_graphics, alpha);
+        }
+        {
+            Profiler::CpuScope scope(profiler, "swap");
+            glfwSwapBuffers(m_window);
+        }
+        profiler.endFrame();
+
+        {
+            std::lock_guard<std::mutex> lock(m_renderMutex);
+            m_submitted = nullptr;
+        }
+        m_renderCondition.notify_all();
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
+
+void Obsidian::submitFrame() {
+    {
+        std::unique_lock<std::mutex> lock(m_renderMutex);
+        // The other list is free again once the previous frame is drawn
+        m_renderCondition.wait(lock, [this] { return m_submitted == nullptr; });
+        m_submitted = &m_commandLists[m_recording];
+        m_submittedAlpha = m_alpha;
+    }
+    m_renderCondition.notify_all();
+    m_recording ^= 1;
+}
+
+void Obsidian::applyRenderCommands() {
+    RenderCommandList& list = m_commandLists[m_recording];
+    if (list.empty()) return;
+    list.execute(m_graphics, m_alpha);
+    list.clear();
+}
+
+bool Obsidian::createOffscreenTarget() {
+    glGenFramebuffers(1, &m_offscreenFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_offscreenFBO);
+
+    glGenRenderbuffers(1, &m_offscreenColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_offscreenColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_offscreenColor);
+
+    glGenRenderbuffers(1, &m_offscreenDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_offscreenDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width, m_height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_offscreenDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Offscreen framebuffer is incomplete\n";
+        destroyOffscreenTarget();
+        return false;
+    }
+    return true;
+}
+
+void Obsidian::destroyOffscreenTarget() {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (m_offscreenFBO) glDeleteFramebuffers(1, &m_offscreenFBO);
+    if (m_offscreenColor) glDeleteRenderbuffers(1, &m_offscreenColor);
+    if (m_offscreenDepth) glDeleteRenderbuffers(1, &m_offscreenDepth);
+    m_offscreenFBO = m_offscreenColor = m_offscreenDepth = 0;
+}
+
+bool Obsidian::saveImage(const std::string& path, int width, int height, const std::vector<unsigned char>& pixels) {
+    if (pixels.size() < static_cast<size_t>(width) * height * 4) {
+        std::cerr << "Image data too small for " << width << "x" << height << ": " << path << "\n";
+        return false;
     }
+    if (!stbi_write_png(path.c_str(), width, height, 4, pixels.data(), width * 4)) {
+        std::cerr << "Failed to write image: " << path << "\n";
+        return false;
+    }
+    return true;
 }
 
 void Obsidian::onResize(int width, int height) {
+    if (m_renderThreadActive) {
+        // Called from glfwPollEvents; the GL side of the resize is the render thread's
+        getRenderCommands().run([width, height](Graphics& graphics) {
+            glViewport(0, 0, width, height);
+            graphics.resize(width, height);
+        });
+        return;
+    }
     glViewport(0, 0, width, height);
     m_graphics.resize(width, height); // ✅ allowed because Obsidian is a friend
 }
@@ -121,6 +432,50 @@ void Obsidian::framebuffer_size_callback(GLFWwindow *window, int width, int heig
     glViewport(0, 0, width, height);
 }
 
+void Obsidian::setFixedTimestep(float tickRate, int maxCatchUpSteps) {
+    m_tickRate = std::max(tickRate, 0.0f);
+    m_maxCatchUpSteps = std::max(maxCatchUpSteps, 1);
+    m_accumulator = 0.0f;
+    m_alpha = 1.0f;
+}
+
+void Obsidian::simulate(float frameTime, bool pollKeys) {
+    auto step = [&](float deltaTime) {
+        if (pollKeys) {
+            for (const auto& [key, action] : keyBindings) {
+                if (glfwGetKey(m_window, key) == GLFW_PRESS) {
+                    action(deltaTime);  // Execute the lambda
+                }
+            }
+        }
+        onFrameDrawn(deltaTime);
+    };
+
+    if (m_tickRate <= 0.0f) {
+        step(frameTime);
+        m_alpha = 1.0f;
+        return;
+    }
+
+    float tick = 1.0f / m_tickRate;
+    m_accumulator += frameTime;
+    int steps = 0;
+    while (m_accumulator >= tick && steps < m_maxCatchUpSteps) {
+        step(tick);
+        m_accumulator -= tick;
+        ++steps;
+    }
+    // Out of catch-up steps: drop the backlog rather than falling further behind
+    if (m_accumulator >= tick) {
+        m_accumulator = std::fmod(m_accumulator, tick);
+    }
+    m_alpha = m_accumulator / tick;
+}
+
+void Obsidian::setThreadedRendering(bool enabled) {
+    m_threadedRendering = enabled;
+}
+
 void Obsidian::addKeyBinding(int key, std::function<void(float)> action) {
     keyBindings[key] = std::move(action);
 }
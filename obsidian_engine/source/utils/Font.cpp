@@ -0,0 +1,215 @@
+#include "../../include/includes.h"
+
+// Empty texels around every glyph so linear filtering never bleeds in a neighbour
+static constexpr int glyphPadding = 1;
+
+// Distance field range in pixels at pixelHeight, relative to a 32 px font.
+// Outlines and glows can reach this far outside the glyph.
+static constexpr float sdfSpreadPer32px = 6.0f;
+
+Font::~Font() {
+    destroy();
+}
+
+bool Font::load(const unsigned char* data, int size, float pixelHeight, FontMode mode) {
+    destroy();
+    if (!data || size <= 0 || pixelHeight <= 0.0f) {
+        std::cerr << "Invalid font data" << std::endl;
+        return false;
+    }
+
+    // stb_truetype keeps pointing into the buffer, so the font owns a copy
+    m_data.assign(data, data + size);
+    int offset = stbtt_GetFontOffsetForIndex(m_data.data(), 0);
+    if (offset < 0 || !stbtt_InitFont(&m_info, m_data.data(), offset)) {
+        std::cerr << "Failed to parse font" << std::endl;
+        m_data.clear();
+        return false;
+    }
+
+    m_pixelHeight = pixelHeight;
+    m_mode = mode;
+    m_sdfSpread = mode == FontMode::SDF ? std::max(2.0f, std::round(sdfSpreadPer32px * pixelHeight / 32.0f)) : 0.0f;
+    m_scale = stbtt_ScaleForPixelHeight(&m_info, pixelHeight);
+
+    int ascent, descent, lineGap;
+    stbtt_GetFontVMetrics(&m_info, &ascent, &descent, &lineGap);
+    m_ascent = ascent * m_scale;
+    m_descent = descent * m_scale;
+    m_lineGap = lineGap * m_scale;
+
+    m_atlasHeight = m_atlasWidth;
+    m_pixels.assign(static_cast<size_t>(m_atlasWidth) * m_atlasHeight, 0);
+    return true;
+}
+
+void Font::destroy() {
+    if (m_texture) {
+        glDeleteTextures(1, &m_texture);
+        m_texture = 0;
+    }
+    ++m_revision;
+    m_data.clear();
+    m_glyphs.clear();
+    m_pixels.clear();
+    m_atlasHeight = 0;
+    m_textureHeight = 0;
+    m_shelfX = m_shelfY = m_shelfHeight = 0;
+    m_dirtyTop = m_dirtyBottom = 0;
+}
+
+const Glyph& Font::glyph(uint32_t codepoint) {
+    auto it = m_glyphs.find(codepoint);
+    if (it != m_glyphs.end()) return it->second;
+
+    Glyph& glyph = m_glyphs[codepoint];
+    if (!loaded()) return glyph;
+
+    glyph.index = stbtt_FindGlyphIndex(&m_info, static_cast<int>(codepoint));
+
+    int advance, leftBearing;
+    stbtt_GetGlyphHMetrics(&m_info, glyph.index, &advance, &leftBearing);
+    glyph.advance = advance * m_scale;
+
+    int x0, y0, width, height;
+    unsigned char* sdf = nullptr;
+    if (m_mode == FontMode::SDF) {
+        // Edge at 128, one spread away from it maps to 0 / 255
+        int spread = static_cast<int>(m_sdfSpread);
+        sdf = stbtt_GetGlyphSDF(&m_info, m_scale, glyph.index, spread, 128, 128.0f / m_sdfSpread,
+                                &width, &height, &x0, &y0);
+        if (!sdf) return glyph;  // Whitespace
+    } else {
+        int x1, y1;
+        stbtt_GetGlyphBitmapBox(&m_info, glyph.index, m_scale, m_scale, &x0, &y0, &x1, &y1);
+        width = x1 - x0;
+        height = y1 - y0;
+        if (width <= 0 || height <= 0) return glyph;  // Whitespace
+    }
+
+    int x, y;
+    if (!allocate(width + glyphPadding * 2, height + glyphPadding * 2, x, y)) {
+        if (sdf) stbtt_FreeSDF(sdf, nullptr);
+        return glyph;
+    }
+
+    glyph.x = x + glyphPadding;
+    glyph.y = y + glyphPadding;
+    glyph.width = width;
+    glyph.height = height;
+    glyph.offset = glm::vec2(x0, -(y0 + height));  // stb boxes are y-down from the baseline
+
+    unsigned char* target = &m_pixels[static_cast<size_t>(glyph.y) * m_atlasWidth + glyph.x];
+    if (sdf) {
+        for (int row = 0; row < height; ++row) {
+            std::copy(sdf + row * width, sdf + (row + 1) * width, target + static_cast<size_t>(row) * m_atlasWidth);
+        }
+        stbtt_FreeSDF(sdf, nullptr);
+    } else {
+        stbtt_MakeGlyphBitmap(&m_info, target, width, height, m_atlasWidth, m_scale, m_scale, glyph.index);
+    }
+
+    if (m_dirtyTop >= m_dirtyBottom) {
+        m_dirtyTop = glyph.y;
+        m_dirtyBottom = glyph.y + height;
+    } else {
+        m_dirtyTop = std::min(m_dirtyTop, glyph.y);
+        m_dirtyBottom = std::max(m_dirtyBottom, glyph.y + height);
+    }
+    return glyph;
+}
+
+float Font::kerning(const Glyph& left, const Glyph& right) const {
+    if (!loaded()) return 0.0f;
+    return stbtt_GetGlyphKernAdvance(&m_info, left.index, right.index) * m_scale;
+}
+
+bool Font::allocate(int width, int height, int& outX, int& outY) {
+    if (width > m_atlasWidth) {
+        std::cerr << "Glyph wider than the font atlas" << std::endl;
+        return false;
+    }
+
+    if (m_shelfX + width > m_atlasWidth) {
+        m_shelfY += m_shelfHeight;
+        m_shelfX = 0;
+        m_shelfHeight = 0;
+    }
+
+    if (m_shelfY + height > m_atlasHeight) {
+        // Rows are only ever appended, so existing glyph rects stay where they are
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        int grown = std::max(m_atlasHeight * 2, m_shelfY + height);
+        if (maxSize > 0 && grown > maxSize) {
+            std::cerr << "Font atlas is full" << std::endl;
+            return false;
+        }
+        m_atlasHeight = grown;
+        m_pixels.resize(static_cast<size_t>(m_atlasWidth) * m_atlasHeight, 0);
+    }
+
+    outX = m_shelfX;
+    outY = m_shelfY;
+    m_shelfX += width;
+    m_shelfHeight = std::max(m_shelfHeight, height);
+    return true;
+}
+
+size_t Font::upload() {
+    if (!loaded()) return 0;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    size_t bytes = 0;
+
+    if (!m_texture || m_textureHeight != m_atlasHeight) {
+        if (!m_texture) glGenTextures(1, &m_texture);
+        glBindTexture(GL_TEXTURE_2D, m_texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, m_atlasWidth, m_atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, m_pixels.data());
+        m_textureHeight = m_atlasHeight;
+        bytes = m_pixels.size();
+    } else if (m_dirtyTop < m_dirtyBottom) {
+        // Whole rows, so the source stride matches the atlas width
+        glBindTexture(GL_TEXTURE_2D, m_texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, m_dirtyTop, m_atlasWidth, m_dirtyBottom - m_dirtyTop, GL_RED,
+                        GL_UNSIGNED_BYTE, &m_pixels[static_cast<size_t>(m_dirtyTop) * m_atlasWidth]);
+        bytes = static_cast<size_t>(m_dirtyBottom - m_dirtyTop) * m_atlasWidth;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    m_dirtyTop = m_dirtyBottom = 0;
+    return bytes;
+}
+
+uint32_t Font::decodeUtf8(const std::string& text, size_t& i) {
+    const uint32_t replacement = 0xFFFD;
+    auto byte = [&](size_t at) { return static_cast<unsigned char>(text[at]); };
+
+    unsigned char lead = byte(i++);
+    if (lead < 0x80) return lead;
+
+    int length;
+    uint32_t codepoint;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 1;
+        codepoint = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 2;
+        codepoint = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 3;
+        codepoint = lead & 0x07;
+    } else {
+        return replacement;
+    }
+
+    for (int n = 0; n < length; ++n) {
+        if (i >= text.size() || (byte(i) & 0xC0) != 0x80) return replacement;
+        codepoint = (codepoint << 6) | (byte(i++) & 0x3F);
+    }
+    return codepoint <= 0x10FFFF ? codepoint : replacement;
+}
@@ -0,0 +1,77 @@
+#include "../../include/includes.h"
+
+GBuffer::~GBuffer() {
+    destroy();
+}
+
+void GBuffer::destroy() {
+    GLuint textures[] = { m_albedo, m_light };
+    GLuint framebuffers[] = { m_albedoFBO, m_lightFBO };
+    if (m_albedo || m_light) glDeleteTextures(2, textures);
+    if (m_albedoFBO || m_lightFBO) glDeleteFramebuffers(2, framebuffers);
+
+    m_albedo = m_light = 0;
+    m_albedoFBO = m_lightFBO = 0;
+    m_width = m_height = 0;
+}
+
+GLuint GBuffer::createTarget(GLuint framebuffer, GLint internalFormat, GLenum type, int width, int height) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, GL_RGBA, type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    return texture;
+}
+
+bool GBuffer::resize(int width, int height) {
+    width = std::max(width, 1);
+    height = std::max(height, 1);
+    if (m_albedo && width == m_width && height == m_height) return true;
+
+    destroy();
+    m_width = width;
+    m_height = height;
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+
+    glGenFramebuffers(1, &m_albedoFBO);
+    glGenFramebuffers(1, &m_lightFBO);
+    m_albedo = createTarget(m_albedoFBO, GL_RGBA8, GL_UNSIGNED_BYTE, width, height);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    // Half floats so overlapping lights can exceed 1 before the composite
+    m_light = createTarget(m_lightFBO, GL_RGBA16F, GL_HALF_FLOAT, width, height);
+    complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+
+    if (!complete) {
+        std::cerr << "G-buffer framebuffer not complete!" << std::endl;
+        destroy();
+        return false;
+    }
+    return true;
+}
+
+void GBuffer::beginGeometry() {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_albedoFBO);
+    glViewport(0, 0, m_width, m_height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void GBuffer::beginLights(const glm::vec3& ambient) {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_lightFBO);
+    glViewport(0, 0, m_width, m_height);
+    glClearColor(ambient.r, ambient.g, ambient.b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
@@ -1,4 +1,5 @@
 #include "../../include/includes.h"
+#include <fstream>
 
 // 2D Vertex Shader with lighting support (no shadows)
 static const char* defaultVertexShader = R"glsl(
@@ -8,8 +9,16 @@ layout(location = 0) in vec2 aPos;
 layout(location = 1) in vec4 aColor;
 layout(location = 2) in vec2 aUV;
 
-uniform mat4 uMVP;
+layout(std140) uniform FrameData {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProj;
+    vec4 uTime;         // x = seconds since start
+};
+
 uniform mat4 uModel;
+uniform vec4 uTint;
+uniform vec4 uUVRect;
 
 out vec4 vColor;
 out vec2 vUV;
@@ -17,159 +26,474 @@ out vec3 vFragPos;
 
 void main() {
     vec4 worldPos = uModel * vec4(aPos, 0.0, 1.0);
-    gl_Position = uMVP * worldPos;
-    vColor = aColor;
-    vUV = aUV;
+    gl_Position = uViewProj * worldPos;
+    vColor = aColor * uTint;
+    vUV = uUVRect.xy + aUV * uUVRect.zw;
     vFragPos = worldPos.xyz;
 }
 )glsl";
 
-// Default Fragment Shader (without shadows)
+// Instanced variant of the default vertex shader, paired with the default fragment shader
+static const char* instancedVertexShader = R"glsl(
+#version 330 core
+
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec4 aColor;
+layout(location = 2) in vec2 aUV;
+layout(location = 3) in mat4 iModel;   // occupies locations 3..6
+layout(location = 7) in vec4 iTint;
+layout(location = 8) in vec4 iUVRect;
+
+layout(std140) uniform FrameData {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProj;
+    vec4 uTime;
+};
+
+out vec4 vColor;
+out vec2 vUV;
+out vec3 vFragPos;
+
+void main() {
+    vec4 worldPos = iModel * vec4(aPos, 0.0, 1.0);
+    gl_Position = uViewProj * worldPos;
+    vColor = aColor * iTint;
+    vUV = iUVRect.xy + aUV * iUVRect.zw;
+    vFragPos = worldPos.xyz;
+}
+)glsl";
+
+// Light model shared by the forward and deferred paths, so both produce the
+// same image. Each shadowed point light owns one row of uShadowMap holding,
+// per direction, the distance to the nearest caster as a fraction of the radius.
+static const char* lightingSource = R"glsl(
+uniform sampler2D uShadowMap;
+
+// Point lights fade out smoothly at their radius
+float pointFalloff(float dist, float radius) {
+    float falloff = clamp(1.0 - dist / radius, 0.0, 1.0);
+    return falloff * falloff;
+}
+
+const float SHADOW_BIAS = 0.005;
+
+// 1 = fully lit, 0 = fully shadowed. row < 0 means the light casts no shadows.
+float shadowFactor(vec2 fromLight, float radius, float row) {
+    if (row < 0.0) return 1.0;
+
+    float dist = length(fromLight) / radius;
+    float u = atan(fromLight.y, fromLight.x) / 6.28318531 + 0.5;
+    float texel = 1.0 / float(textureSize(uShadowMap, 0).x);
+
+    // 5 taps along the angle soften the edges a little
+    float lit = 0.0;
+    for (int k = -2; k <= 2; ++k) {
+        float occluder = texture(uShadowMap, vec2(u + float(k) * texel, row)).r;
+        lit += (occluder >= 1.0 || dist <= occluder + SHADOW_BIAS) ? 1.0 : 0.0;
+    }
+    return lit / 5.0;
+}
+)glsl";
+
+// Default Fragment Shader
 static const char* defaultFragmentShader = R"glsl(
 #version 330 core
 
 out vec4 FragColor;
 
+// std140 layout, mirrored by GpuLight on the CPU side
 struct Light {
-    int type;       // 0=ambient,1=directional,2=point/spot
-    vec3 position;
-    vec3 direction;
-    vec3 color;
-    float intensity;
-    float cutoff;   // spotlight cutoff cosine
+    vec4 position;  // xy = position, w = type (0=ambient,1=directional,2=point/spot)
+    vec4 direction; // xy = direction
+    vec4 color;     // rgb = color, a = intensity
+    vec4 params;    // x = spotlight cutoff cosine, y = radius, z = shadow map row or -1
 };
 
-#define MAX_LIGHTS 8
+// MAX_LIGHTS is injected by Graphics from the configured light budget
+layout(std140) uniform Lights {
+    int uNumLights;
+    Light uLights[MAX_LIGHTS];
+};
 
 in vec4 vColor;
 in vec2 vUV;
 in vec3 vFragPos;
 
 uniform sampler2D uTexture;
-uniform Light uLights[MAX_LIGHTS];
-uniform int uNumLights;
+
+#ifdef TILED
+// Per-tile light lists built by LightGrid, see its header for the layout
+uniform samplerBuffer uLightData;
+uniform isamplerBuffer uLightTiles;
+#endif
 
 void main() {
-    vec3 norm = vec3(0.0, 0.0, 1.0);
-    vec3 result = vec3(0.0);
     vec4 texColor = texture(uTexture, vUV);
 
+    // TextMesh variants: the texture is a single-channel font atlas
+#if defined(GLYPH_SDF)
+    float edge = max(fwidth(texColor.r) * 0.5, 1e-4);
+    texColor = vec4(1.0, 1.0, 1.0, smoothstep(0.5 - edge, 0.5 + edge, texColor.r));
+#elif defined(GLYPH_COVERAGE)
+    texColor = vec4(1.0, 1.0, 1.0, texColor.r);
+#endif
+
+#ifdef DEFERRED
+    // Unlit albedo; the light accumulation pass adds the lighting
+    FragColor = vColor * texColor;
+#else
+    vec3 result = vec3(0.0);
+
+#ifdef TILED
+    vec4 header = texelFetch(uLightData, 0);
+    float tileSize = texelFetch(uLightData, 1).x;
+    ivec2 tile = ivec2(gl_FragCoord.xy / tileSize);
+    int entry = (tile.y * int(header.w) + tile.x) * 2;
+    int first = texelFetch(uLightTiles, entry).r;
+    int count = texelFetch(uLightTiles, entry + 1).r;
+
+    result = header.rgb;
+    for (int i = 0; i < count; ++i) {
+        int index = texelFetch(uLightTiles, first + i).r;
+        vec4 light = texelFetch(uLightData, 2 + index * 2);
+        vec2 fromLight = vFragPos.xy - light.xy;
+        float attenuation = pointFalloff(length(fromLight), light.z);
+        if (attenuation > 0.0) {
+            result += texelFetch(uLightData, 3 + index * 2).rgb * attenuation * shadowFactor(fromLight, light.z, light.w);
+        }
+    }
+#else
     for (int i = 0; i < uNumLights; ++i) {
         Light light = uLights[i];
-        vec3 lightColor = light.color * light.intensity;
-        vec3 lightContribution = vec3(0.0);
-
-        if (light.type == 0) {
-            // Ambient light
-            lightContribution = lightColor;
-        } else if (light.type == 1) {
-            // Directional light (simple diffuse)
-            vec3 lightDir = normalize(-light.direction);
-            float diff = max(dot(norm, lightDir), 0.0);
-            lightContribution = diff * lightColor;
-        } else if (light.type == 2) {
-            // Point/Spot light (simple radial falloff, no cone here)
-            vec3 lightDir = normalize(light.position - vFragPos);
-            float diff = max(dot(norm, lightDir), 0.0);
-            float distance = length(light.position - vFragPos);
-            float attenuation = 1.0 / (distance * distance + 0.01);
-            lightContribution = diff * lightColor * attenuation;
+        int type = int(light.position.w);
+        vec3 lightColor = light.color.rgb * light.color.a;
+
+        if (type == 0 || type == 1) {
+            // Ambient and directional light reach the whole scene plane evenly
+            result += lightColor;
+        } else if (type == 2) {
+            // Point light (radial falloff, no cone here)
+            vec2 fromLight = vFragPos.xy - light.position.xy;
+            float attenuation = pointFalloff(length(fromLight), light.params.y);
+            if (attenuation > 0.0) {
+                result += lightColor * attenuation * shadowFactor(fromLight, light.params.y, light.params.z);
+            }
         }
-
-        result += lightContribution;
     }
+#endif
 
     vec3 finalColor = result * vColor.rgb * texColor.rgb;
     FragColor = vec4(finalColor, vColor.a * texColor.a);
+#endif
 }
 )glsl";
 
-// Fullscreen Quad Vertex Shader (for spotlight glow)
-static const char* fullscreenQuadVertexShader = R"glsl(
+// Light glow: one instanced quad per light, fitted around the cone sector
+// that `cutoff` and `radius` describe, so only glowing pixels are shaded
+static const char* lightGlowVertexShader = R"glsl(
 #version 330 core
 
-layout(location = 0) in vec2 aPos;
-layout(location = 1) in vec2 aUV;
+layout(location = 0) in vec2 aCorner;     // -1..1
+layout(location = 1) in vec4 iLight;      // xy = position, z = radius, w = shadow map row
+layout(location = 2) in vec4 iDirection;  // xy = direction, z = cutoff cosine
+layout(location = 3) in vec4 iColor;      // rgb = color, a = intensity
 
-uniform mat4 uModel;
-uniform mat4 uMVP;
+layout(std140) uniform FrameData {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProj;
+    vec4 uTime;
+};
 
-out vec2 vUV;
 out vec2 vFragPos;
+flat out vec4 vLight;
+flat out vec4 vDirection;
+flat out vec4 vColor;
 
 void main() {
-    vec4 worldPos = uModel * vec4(aPos, 0.0, 1.0);
-    gl_Position = uMVP * worldPos;
-    vFragPos = worldPos.xy;
-    vUV = aUV;
+    // Bounds of the sector in the light's frame, x along its direction
+    float halfAngle = acos(clamp(iDirection.z, -1.0, 1.0));
+    float radius = iLight.z;
+    float halfWidth = halfAngle >= 1.57079633 ? radius : radius * sin(halfAngle);
+    vec2 lo = vec2(min(0.0, radius * cos(halfAngle)), -halfWidth);
+    vec2 hi = vec2(radius, halfWidth);
+    vec2 local = mix(lo, hi, aCorner * 0.5 + 0.5);
+
+    vec2 dir = normalize(iDirection.xy);
+    vec2 worldPos = iLight.xy + dir * local.x + vec2(-dir.y, dir.x) * local.y;
+    gl_Position = uViewProj * vec4(worldPos, 0.0, 1.0);
+
+    vFragPos = worldPos;
+    vLight = iLight;
+    vDirection = iDirection;
+    vColor = iColor;
 }
 )glsl";
 
-// Fullscreen Quad Fragment Shader (spotlight glow effect)
-static const char* fullscreenQuadFragmentShader = R"glsl(
+static const char* lightGlowFragmentShader = R"glsl(
 #version 330 core
 
 in vec2 vFragPos;
-out vec4 FragColor;
+flat in vec4 vLight;
+flat in vec4 vDirection;
+flat in vec4 vColor;
 
-uniform vec2 uLightPos;     // in world coordinates (pixels)
-uniform vec2 uLightDir;     // normalized direction in world coords
-uniform float uCutoff;
-uniform vec3 uLightColor;
-uniform float uIntensity;
-uniform float uRadius;
+out vec4 FragColor;
 
 void main() {
-    vec2 toLight = normalize(vFragPos - uLightPos);
-    float dist = distance(vFragPos, uLightPos);
+    vec2 lightPos = vLight.xy;
+    float radius = vLight.z;
+    float cutoff = vDirection.z;
 
-    float theta = dot(toLight, normalize(uLightDir));
-    float coneMask = smoothstep(uCutoff, uCutoff + 0.1, theta);
+    vec2 toLight = normalize(vFragPos - lightPos);
+    float dist = distance(vFragPos, lightPos);
 
-    float radialFalloff = clamp(1.0 - dist / uRadius, 0.0, 1.0);
-    float intensity = coneMask * radialFalloff * uIntensity;
+    float theta = dot(toLight, normalize(vDirection.xy));
+    float coneMask = smoothstep(cutoff, cutoff + 0.1, theta);
+
+    float radialFalloff = clamp(1.0 - dist / radius, 0.0, 1.0);
+    float shadow = shadowFactor(vFragPos - lightPos, radius, vLight.w);
+    float intensity = coneMask * radialFalloff * shadow * vColor.a;
 
     if (intensity < 0.01)
         discard;
 
-    FragColor = vec4(uLightColor, intensity);
+    FragColor = vec4(vColor.rgb, intensity);
+}
+)glsl";
+
+// Deferred lighting: one instanced quad per point light, bounded by its
+// radius, added into the light accumulation texture
+static const char* deferredLightVertexShader = R"glsl(
+#version 330 core
+
+layout(location = 0) in vec2 aCorner;  // -1..1
+layout(location = 1) in vec4 iLight;   // xy = position, z = radius, w = shadow map row
+layout(location = 2) in vec4 iColor;   // rgb = color * intensity
+
+layout(std140) uniform FrameData {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProj;
+    vec4 uTime;
+};
+
+out vec2 vFragPos;
+flat out vec4 vLight;
+flat out vec3 vColor;
+
+void main() {
+    vec2 worldPos = iLight.xy + aCorner * iLight.z;
+    gl_Position = uViewProj * vec4(worldPos, 0.0, 1.0);
+    vFragPos = worldPos;
+    vLight = iLight;
+    vColor = iColor.rgb;
 }
 )glsl";
 
-GLuint fullscreenQuadVAO = 0, fullscreenQuadVBO = 0;
+static const char* deferredLightFragmentShader = R"glsl(
+#version 330 core
 
-void createFullscreenQuad(int width, int height) {
-    if (fullscreenQuadVAO != 0) return;
+in vec2 vFragPos;
+flat in vec4 vLight;
+flat in vec3 vColor;
 
-    float halfW = width * 0.5f;
-    float halfH = height * 0.5f;
+out vec4 FragColor;
 
-    float quadVertices[] = {
-        // positions (in pixels)      // UVs
-        -halfW, -halfH,  0.0f, 0.0f,
-         halfW, -halfH,  1.0f, 0.0f,
-         halfW,  halfH,  1.0f, 1.0f,
+void main() {
+    vec2 fromLight = vFragPos - vLight.xy;
+    float attenuation = pointFalloff(length(fromLight), vLight.z);
+    if (attenuation <= 0.0) discard;
 
-        -halfW, -halfH,  0.0f, 0.0f,
-         halfW,  halfH,  1.0f, 1.0f,
-        -halfW,  halfH,  0.0f, 1.0f,
-    };
+    FragColor = vec4(vColor * attenuation * shadowFactor(fromLight, vLight.z, vLight.w), 1.0);
+}
+)glsl";
 
-    glGenVertexArrays(1, &fullscreenQuadVAO);
-    glGenBuffers(1, &fullscreenQuadVBO);
-    glBindVertexArray(fullscreenQuadVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, fullscreenQuadVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+// Deferred composite: albedo * accumulated light, as one screen-covering triangle
+static const char* compositeVertexShader = R"glsl(
+#version 330 core
 
-    // pos
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+out vec2 vUV;
 
-    // uv
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+void main() {
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    vUV = corner;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)glsl";
 
-    glBindVertexArray(0);
+static const char* compositeFragmentShader = R"glsl(
+#version 330 core
+
+in vec2 vUV;
+out vec4 FragColor;
+
+uniform sampler2D uAlbedo;
+uniform sampler2D uLight;
+
+void main() {
+    vec4 albedo = texture(uAlbedo, vUV);
+    FragColor = vec4(albedo.rgb * texture(uLight, vUV).rgb, 1.0);
+}
+)glsl";
+
+// Text: one instanced quad per glyph, sampling the font's single-channel atlas.
+// Glyphs carry their atlas rect in pixels, so the atlas may grow mid-frame.
+// With SDF defined the atlas holds distances and the fragment shader resolves
+// the edge, outline and glow per pixel.
+static const char* textVertexShader = R"glsl(
+#version 330 core
+
+layout(location = 0) in vec2 aCorner;    // -1..1
+layout(location = 1) in vec4 iPosition;  // xy = bottom-left corner, zw = bottom edge
+layout(location = 2) in vec4 iUp;        // xy = left edge, z = 1 for window pixels
+layout(location = 3) in vec4 iGlyph;     // Atlas rect in pixels: xy = top-left, zw = size
+layout(location = 4) in vec4 iColor;
+layout(location = 5) in vec4 iOutline;   // rgb, a = width in font pixels
+layout(location = 6) in vec4 iGlow;      // rgb, a = radius in font pixels
+
+layout(std140) uniform FrameData {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProj;
+    vec4 uTime;
+};
+
+uniform vec2 uAtlasSize;
+uniform vec2 uScreenSize;
+
+out vec2 vUV;
+flat out vec4 vColor;
+flat out vec4 vOutline;
+flat out vec4 vGlow;
+
+void main() {
+    vec2 t = aCorner * 0.5 + 0.5;
+    vec2 pos = iPosition.xy + iPosition.zw * t.x + iUp.xy * t.y;
+    if (iUp.z > 0.5) {
+        gl_Position = vec4(pos / uScreenSize * 2.0 - 1.0, 0.0, 1.0);
+    } else {
+        gl_Position = uViewProj * vec4(pos, 0.0, 1.0);
+    }
+
+    // Atlas rows run top-down
+    vUV = (iGlyph.xy + vec2(t.x, 1.0 - t.y) * iGlyph.zw) / uAtlasSize;
+    vColor = iColor;
+    vOutline = iOutline;
+    vGlow = iGlow;
+}
+)glsl";
+
+static const char* textFragmentShader = R"glsl(
+#version 330 core
+
+in vec2 vUV;
+flat in vec4 vColor;
+flat in vec4 vOutline;
+flat in vec4 vGlow;
+
+out vec4 FragColor;
+
+uniform sampler2D uAtlas;
+
+#ifdef SDF
+uniform float uSdfSpread;  // Font pixels between the edge (0.5) and 0 or 1
+
+// Non-premultiplied "src over dst"
+vec4 over(vec4 src, vec4 dst) {
+    float a = src.a + dst.a * (1.0 - src.a);
+    vec3 rgb = a > 0.0 ? (src.rgb * src.a + dst.rgb * dst.a * (1.0 - src.a)) / a : vec3(0.0);
+    return vec4(rgb, a);
+}
+#endif
+
+void main() {
+#ifdef SDF
+    // Signed distance to the outline in font pixels, positive inside
+    float dist = (texture(uAtlas, vUV).r - 0.5) * 2.0 * uSdfSpread;
+    // Half a screen pixel in font pixels, whatever the scale or rotation
+    float aa = max(fwidth(dist) * 0.5, 1e-4);
+
+    vec4 color = vec4(vGlow.rgb, 0.0);
+    if (vGlow.a > 0.0) {
+        float falloff = 1.0 - smoothstep(0.0, vGlow.a, -dist);
+        color.a = falloff * falloff;
+    }
+    if (vOutline.a > 0.0) {
+        color = over(vec4(vOutline.rgb, smoothstep(-aa, aa, dist + vOutline.a)), color);
+    }
+    color = over(vec4(vColor.rgb, smoothstep(-aa, aa, dist)), color);
+    FragColor = vec4(color.rgb, color.a * vColor.a);
+#else
+    FragColor = vec4(vColor.rgb, vColor.a * texture(uAtlas, vUV).r);
+#endif
+}
+)glsl";
+
+// Polar shadow map rendering (see ShadowMap). Each quad covers the angular
+// range of one caster edge; the depth written is the exact distance along the
+// fragment's direction, so the depth test keeps the nearest edge.
+static const char* shadowVertexShader = R"glsl(
+#version 330 core
+
+layout(location = 0) in vec2 aPos;      // x = angle / pi, y = row
+layout(location = 1) in vec4 aSegment;  // Edge endpoints relative to the light, in radii
+
+flat out vec4 vSegment;
+
+void main() {
+    gl_Position = vec4(aPos, 0.0, 1.0);
+    vSegment = aSegment;
+}
+)glsl";
+
+static const char* shadowFragmentShader = R"glsl(
+#version 330 core
+
+flat in vec4 vSegment;
+
+uniform float uResolution;
+
+void main() {
+    float angle = gl_FragCoord.x / uResolution * 6.28318531 - 3.14159265;
+    vec2 ray = vec2(cos(angle), sin(angle));
+    vec2 a = vSegment.xy;
+    vec2 edge = vSegment.zw - a;
+
+    // Ray/edge intersection, clamped to the edge for the padded texels
+    float denom = edge.x * ray.y - edge.y * ray.x;
+    float dist;
+    if (abs(denom) > 1e-6) {
+        float s = clamp((ray.x * a.y - ray.y * a.x) / denom, 0.0, 1.0);
+        dist = length(a + s * edge);
+    } else {
+        dist = min(length(a), length(vSegment.zw));
+    }
+    gl_FragDepth = min(dist, 1.0);
+}
+)glsl";
+
+// Texture unit the shadow map stays bound to; shapes only use unit 0
+static constexpr GLint shadowTextureUnit = 1;
+// Light accumulation texture during the deferred composite
+static constexpr GLint lightTextureUnit = 2;
+// LightGrid buffer textures in tiled mode
+static constexpr GLint lightDataUnit = 3;
+static constexpr GLint lightTilesUnit = 4;
+
+// Inserts text right after the #version line of a shader source
+static std::string afterVersion(const std::string& source, const std::string& text) {
+    std::string src(source);
+    size_t version = src.find("#version");
+    size_t lineEnd = version == std::string::npos ? std::string::npos : src.find('\n', version);
+    if (lineEnd == std::string::npos) return text + src;
+    return src.insert(lineEnd + 1, text);
+}
+
+// Inserts a #define right after the #version line of a shader source
+static std::string withDefine(const std::string& source, const std::string& name, int value) {
+    return afterVersion(source, "#define " + name + " " + std::to_string(value) + "\n");
 }
 
 Graphics::Graphics() {
@@ -193,22 +517,194 @@ bool Graphics::initialize(const Obsidian& engine) {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    // Default white texture
-    unsigned char whitePixel[4] = { 255, 255, 255, 255 };
-    glGenTextures(1, &whiteTexture);
-    glBindTexture(GL_TEXTURE_2D, whiteTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, whitePixel);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    // Texture registry, also creates the shared white texture
+    m_textures.initialize();
+    m_loader.initialize(m_textures);
+    m_meshes.initialize();
+
+    glGenBuffers(1, &m_frameUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_frameUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBlock::Frame), m_frameUBO);
+
+    glGenBuffers(1, &m_lightsUBO);
+    glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBlock::Lights), m_lightsUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    if (!loadBuiltinShaders()) return false;
+
+    // Unit quad shared by the instanced light passes
+    const float corners[] = { -1.0f, -1.0f,  1.0f, -1.0f,  -1.0f, 1.0f,  1.0f, 1.0f };
+    glGenBuffers(1, &m_cornerVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_cornerVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    if (!loadShader(defaultVertexShader, defaultFragmentShader, "default")) return false;
-    if (!loadShader(fullscreenQuadVertexShader, fullscreenQuadFragmentShader, "fullscreenQuad")) return false;
+    m_stream.initialize(GL_ARRAY_BUFFER, 4 << 20);
+    m_batch.initialize(m_stream);
+
+    return true;
+}
+
+bool Graphics::loadBuiltinShaders() {
+    // Keep the light array inside the guaranteed uniform block size
+    GLint maxBlockSize = 16384;
+    glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxBlockSize);
+    int maxLights = static_cast<int>((maxBlockSize - GpuLight::headerSize) / sizeof(GpuLight));
+    if (m_lightBudget > maxLights) {
+        std::cerr << "Light budget " << m_lightBudget << " exceeds uniform block limit, using " << maxLights << std::endl;
+        m_lightBudget = maxLights;
+    }
+    if (m_lightBudget < 1) m_lightBudget = 1;
+
+    std::string fragment = withDefine(afterVersion(defaultFragmentShader, lightingSource),
+                                      "MAX_LIGHTS", m_lightBudget);
+    if (m_lightingMode == LightingMode::Deferred) {
+        fragment = withDefine(fragment, "DEFERRED", 1);
+    } else if (m_lightingMode == LightingMode::Tiled) {
+        fragment = withDefine(fragment, "TILED", 1);
+    }
+    std::string glowFragment = afterVersion(lightGlowFragmentShader, lightingSource);
+    std::string lightFragment = afterVersion(deferredLightFragmentShader, lightingSource);
+
+    if (!loadShader(defaultVertexShader, fragment, "default")) return false;
+    if (!loadShader(defaultVertexShader, withDefine(fragment, "GLYPH_COVERAGE", 1), "textMesh")) return false;
+    if (!loadShader(defaultVertexShader, withDefine(fragment, "GLYPH_SDF", 1), "textMeshSdf")) return false;
+    if (!loadShader(lightGlowVertexShader, glowFragment, "lightGlow")) return false;
+    if (!loadShader(instancedVertexShader, fragment, "instanced")) return false;
+    if (!loadShader(shadowVertexShader, shadowFragmentShader, "shadow")) return false;
+    if (!loadShader(deferredLightVertexShader, lightFragment, "deferredLight")) return false;
+    if (!loadShader(compositeVertexShader, compositeFragmentShader, "composite")) return false;
+    if (!loadShader(textVertexShader, textFragmentShader, "text")) return false;
+    if (!loadShader(textVertexShader, withDefine(textFragmentShader, "SDF", 1), "textSdf")) return false;
+
+    // unordered_map nodes are stable, so these stay valid until cleanup()
+    m_defaultProgram = findProgram("default");
+    m_instancedProgram = findProgram("instanced");
+    m_glowProgram = findProgram("lightGlow");
+    m_shadowProgram = findProgram("shadow");
+    m_deferredLightProgram = findProgram("deferredLight");
+    m_compositeProgram = findProgram("composite");
+    m_textProgram = findProgram("text");
+    m_textSdfProgram = findProgram("textSdf");
+
+    // Samplers keep their unit, so point them at the shadow map once
+    const ShaderProgram* textMeshPrograms[] = { findProgram("textMesh"), findProgram("textMeshSdf") };
+    for (const ShaderProgram* program : { m_defaultProgram, m_instancedProgram, m_glowProgram, m_deferredLightProgram,
+                                          textMeshPrograms[0], textMeshPrograms[1] }) {
+        bindProgram(*program);
+        glUniform1i(program->location(UniformID::ShadowMap), shadowTextureUnit);
+    }
+    for (const ShaderProgram* program : { m_defaultProgram, m_instancedProgram, textMeshPrograms[0], textMeshPrograms[1] }) {
+        bindProgram(*program);
+        glUniform1i(program->location("uLightData"), lightDataUnit);
+        glUniform1i(program->location("uLightTiles"), lightTilesUnit);
+    }
+    bindProgram(*m_compositeProgram);
+    glUniform1i(m_compositeProgram->location("uAlbedo"), 0);
+    glUniform1i(m_compositeProgram->location("uLight"), lightTextureUnit);
 
-    createFullscreenQuad(width, height);
+    // Size the light buffer for the new budget and force a re-upload
+    glBindBuffer(GL_UNIFORM_BUFFER, m_lightsUBO);
+    glBufferData(GL_UNIFORM_BUFFER, GpuLight::headerSize + sizeof(GpuLight) * m_lightBudget, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    m_uploadedLights.clear();
+    m_lightsUploaded = false;
 
     return true;
 }
 
+void Graphics::setLightBudget(int maxLights) {
+    m_lightBudget = maxLights;
+
+    // Already running: rebuild the shaders that declare the light array
+    if (m_defaultProgram) {
+        loadBuiltinShaders();
+    }
+}
+
+int Graphics::getLightBudget() const {
+    return m_lightBudget;
+}
+
+void Graphics::setLightingMode(LightingMode mode) {
+    if (mode == m_lightingMode) return;
+    m_lightingMode = mode;
+
+    // Already running: the default shaders switch between lit and albedo output
+    if (m_defaultProgram) {
+        loadBuiltinShaders();
+    }
+}
+
+LightingMode Graphics::getLightingMode() const {
+    return m_lightingMode;
+}
+
+void Graphics::setLightTileSize(int pixels) {
+    m_lightGrid.setTileSize(pixels);
+}
+
+void Graphics::setShadowResolution(int texels) {
+    m_shadows.setResolution(texels);
+}
+
+void Graphics::updateFrameBuffer(const glm::mat4& view, const glm::mat4& projection) {
+    glm::vec4 time(static_cast<float>(glfwGetTime()), 0.0f, 0.0f, 0.0f);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_frameUBO);
+    if (!m_frameUploaded || view != m_uploadedView || projection != m_uploadedProjection) {
+        FrameBlock block{ view, projection, projection * view, time };
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameBlock), &block);
+        m_stats.uploadedBytes += sizeof(FrameBlock);
+        m_uploadedView = view;
+        m_uploadedProjection = projection;
+        m_frameUploaded = true;
+    } else {
+        // Matrices unchanged, only the clock moves
+        glBufferSubData(GL_UNIFORM_BUFFER, offsetof(FrameBlock, time), sizeof(glm::vec4), &time);
+        m_stats.uploadedBytes += sizeof(glm::vec4);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void Graphics::updateLightBuffer() {
+    size_t count = std::min(lights.size(), static_cast<size_t>(m_lightBudget));
+
+    m_packedLights.clear();
+    for (size_t i = 0; i < count; ++i) {
+        const auto& light = lights[i];
+        m_packedLights.push_back({
+            glm::vec4(light->position, 0.0f, static_cast<float>(light->type)),
+            glm::vec4(light->direction, 0.0f, 0.0f),
+            glm::vec4(light->color, light->intensity),
+            glm::vec4(light->cutoff, light->radius, m_shadows.rowCoord(*light), 0.0f)
+        });
+    }
+
+    // Lights are plain structs without change notification, so compare the packed data
+    bool unchanged = m_lightsUploaded && m_packedLights.size() == m_uploadedLights.size()
+        && std::equal(m_packedLights.begin(), m_packedLights.end(), m_uploadedLights.begin(),
+                      [](const GpuLight& a, const GpuLight& b) {
+                          return a.position == b.position && a.direction == b.direction
+                              && a.color == b.color && a.params == b.params;
+                      });
+    if (unchanged) return;
+
+    GLint header[4] = { static_cast<GLint>(count), 0, 0, 0 };
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_lightsUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(header), header);
+    if (count > 0) {
+        glBufferSubData(GL_UNIFORM_BUFFER, GpuLight::headerSize, sizeof(GpuLight) * count, m_packedLights.data());
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    m_stats.uploadedBytes += GpuLight::headerSize + sizeof(GpuLight) * count;
+
+    m_uploadedLights.swap(m_packedLights);
+    m_lightsUploaded = true;
+}
+
 void Graphics::updateProjection() {
     float halfWidth = static_cast<float>(m_windowWidth) * 0.5f;
     float halfHeight = static_cast<float>(m_windowHeight) * 0.5f;
@@ -252,31 +748,102 @@ bool Graphics::loadShader(const std::string& vertexSrc, const std::string& fragm
     glDeleteShader(vertShader);
     glDeleteShader(fragShader);
     if (!program) return false;
-    shaderPrograms[shaderName] = program;
+
+    auto existing = shaderPrograms.find(shaderName);
+    if (existing != shaderPrograms.end()) {
+        if (currentProgram == existing->second.id) currentProgram = 0;
+        glDeleteProgram(existing->second.id);
+    }
+
+    ShaderProgram& entry = shaderPrograms[shaderName];
+    entry.id = program;
+    entry.reflect();
+
+    // Every engine shader samples unit 0, so the sampler only needs setting once
+    GLint textureLoc = entry.location(UniformID::Texture);
+    if (textureLoc >= 0) {
+        bindProgram(entry);
+        glUniform1i(textureLoc, 0);
+    }
     return true;
 }
 
 void Graphics::useShader(const std::string& shaderName) {
     auto it = shaderPrograms.find(shaderName);
     if (it != shaderPrograms.end()) {
-        if (currentProgram != it->second) {
-            glUseProgram(it->second);
-            currentProgram = it->second;
-        }
-        GLint loc = glGetUniformLocation(currentProgram, "uTexture");
-        if (loc >= 0) glUniform1i(loc, 0);
+        bindProgram(it->second);
+    }
+}
+
+void Graphics::bindProgram(const ShaderProgram& program) {
+    if (currentProgram != program.id) {
+        glUseProgram(program.id);
+        currentProgram = program.id;
+        m_stats.stateChanges++;
     }
 }
 
+const ShaderProgram* Graphics::findProgram(const std::string& shaderName) const {
+    auto it = shaderPrograms.find(shaderName);
+    return it != shaderPrograms.end() ? &it->second : nullptr;
+}
+
+void Graphics::setUniformMat4(const std::string& shaderName, const std::string& uniform, const glm::mat4& matrix) {
+    auto it = shaderPrograms.find(shaderName);
+    if (it == shaderPrograms.end()) return;
+
+    GLint loc = it->second.location(uniform);
+    if (loc < 0) return;
+
+    bindProgram(it->second);
+    glUniformMatrix4fv(loc, 1, GL_FALSE, &matrix[0][0]);
+}
+
 void Graphics::bindTexture(GLuint tex) {
+    if (currentTexture == tex) return;
+
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, tex);
+    currentTexture = tex;
+    m_stats.stateChanges++;
     GLenum err = glGetError();
     if (err != GL_NO_ERROR) {
         std::cerr << "OpenGL error: " << std::hex << err << std::dec << std::endl;
     }
-    GLint loc = glGetUniformLocation(currentProgram, "uTexture");
-    if (loc >= 0) glUniform1i(loc, 0);
+}
+
+GLuint Graphics::loadTexture(const std::string& path, GLint filtering) {
+    // Callers only get the raw id, so keep a handle alive until cleanup().
+    // Repeated loads of the same file return the pinned handle.
+    std::string key = TextureRegistry::fileKey(path, filtering);
+    auto pinned = m_pinnedTextures.find(key);
+    if (pinned != m_pinnedTextures.end()) return pinned->second.getData();
+
+    Texture texture = m_textures.load(path, filtering);
+    if (texture.getData()) {
+        m_pinnedTextures.emplace(key, texture);
+    }
+    return texture.getData();
+}
+
+GLuint Graphics::getDefaultTexture() {
+    return m_textures.white().getData();
+}
+
+TextureRegistry& Graphics::getTextures() {
+    return m_textures;
+}
+
+Texture Graphics::loadTextureAsync(const std::string& path, GLint filtering, TextureReadyCallback onReady) {
+    return m_loader.load(path, filtering, std::move(onReady));
+}
+
+TextureLoader& Graphics::getTextureLoader() {
+    return m_loader;
+}
+
+void Graphics::setTextureUploadBudget(double milliseconds) {
+    m_uploadBudgetMs = std::max(milliseconds, 0.0);
 }
 
 GLuint Graphics::compileShader(GLenum type, const std::string& source) {
@@ -317,31 +884,173 @@ GLuint Graphics::linkProgram(GLuint vertShader, GLuint fragShader) {
 
 void Graphics::cleanup() {
     for (auto& [name, prog] : shaderPrograms) {
-        glDeleteProgram(prog);
+        glDeleteProgram(prog.id);
     }
     shaderPrograms.clear();
-
-    if (whiteTexture) {
-        glDeleteTextures(1, &whiteTexture);
-        whiteTexture = 0;
+    currentProgram = 0;
+    currentTexture = 0;
+    m_defaultProgram = nullptr;
+    m_instancedProgram = nullptr;
+    m_glowProgram = nullptr;
+    m_shadowProgram = nullptr;
+    m_deferredLightProgram = nullptr;
+    m_compositeProgram = nullptr;
+    m_textProgram = nullptr;
+    m_textSdfProgram = nullptr;
+
+    m_shadows.destroy();
+    m_gbuffer.destroy();
+    m_lightGrid.destroy();
+    m_profiler.destroy();
+    m_font.destroy();
+    m_textInstances.clear();
+    if (m_cornerVBO) {
+        glDeleteBuffers(1, &m_cornerVBO);
+        m_cornerVBO = 0;
+    }
+    if (m_lightQuadVAO) {
+        glDeleteVertexArrays(1, &m_lightQuadVAO);
+        m_lightQuadVAO = 0;
+    }
+    if (m_glowVAO) {
+        glDeleteVertexArrays(1, &m_glowVAO);
+        m_glowVAO = 0;
     }
+    if (m_textVAO) {
+        glDeleteVertexArrays(1, &m_textVAO);
+        m_textVAO = 0;
+    }
+    if (m_compositeVAO) {
+        glDeleteVertexArrays(1, &m_compositeVAO);
+        m_compositeVAO = 0;
+    }
+    m_pinnedTextures.clear();
+    m_loader.shutdown();
+    m_textures.shutdown();
+    m_meshes.shutdown();
+
 
-    if (fullscreenQuadVBO) {
-        glDeleteBuffers(1, &fullscreenQuadVBO);
-        fullscreenQuadVBO = 0;
+    m_batch.destroy();
+
+    if (m_frameUBO) {
+        glDeleteBuffers(1, &m_frameUBO);
+        m_frameUBO = 0;
+        m_frameUploaded = false;
     }
-    if (fullscreenQuadVAO) {
-        glDeleteVertexArrays(1, &fullscreenQuadVAO);
-        fullscreenQuadVAO = 0;
+    if (m_lightsUBO) {
+        glDeleteBuffers(1, &m_lightsUBO);
+        m_lightsUBO = 0;
+        m_lightsUploaded = false;
     }
+
+    m_stream.destroy();
 }
 
 Camera* Graphics::getCamera() {
     return &m_camera;
 }
 
-void Graphics::addShape(std::shared_ptr<Shape> shape) {
-    shapes.push_back(shape);
+ShapeHandle Graphics::addShape(std::shared_ptr<Shape> shape) {
+    if (!shape) return ShapeHandle();
+
+    // Already registered here
+    const auto* existing = shapes.get(shape->m_handle);
+    if (existing && *existing == shape) return shape->m_handle;
+
+    shape->setVertexFormat(m_batch.getFormat());
+    m_grid.insert(shape.get());
+    m_queue.track(shape.get());
+
+    shape->m_handle = shapes.insert(shape);
+    return shape->m_handle;
+}
+
+bool Graphics::removeShape(ShapeHandle handle) {
+    auto* slot = shapes.get(handle);
+    if (!slot) return false;
+
+    // Keep the shape alive until every index has let go of it
+    std::shared_ptr<Shape> shape = *slot;
+    m_grid.remove(shape.get());
+    m_queue.remove(shape.get());
+    shapes.remove(handle);
+    shape->m_handle = ShapeHandle();
+    return true;
+}
+
+bool Graphics::removeShape(const std::shared_ptr<Shape>& shape) {
+    if (!shape) return false;
+
+    const auto* slot = shapes.get(shape->m_handle);
+    if (!slot || *slot != shape) return false;
+    return removeShape(shape->m_handle);
+}
+
+std::shared_ptr<Shape> Graphics::getShape(ShapeHandle handle) const {
+    const auto* slot = shapes.get(handle);
+    return slot ? *slot : nullptr;
+}
+
+size_t Graphics::getShapeCount() const {
+    return shapes.size();
+}
+
+void Graphics::compactShapes() {
+    shapes.compact();
+}
+
+void Graphics::setCulling(bool enabled) {
+    m_culling = enabled;
+}
+
+void Graphics::setCullingCellSize(float cellSize) {
+    m_grid.setCellSize(cellSize);
+}
+
+AABB Graphics::getViewBounds() const {
+    // Unproject the clip-space corners; covers zoom and custom projections alike
+    glm::mat4 inverse = glm::inverse(m_projection * m_camera.getViewMatrix());
+
+    AABB bounds;
+    for (int corner = 0; corner < 4; ++corner) {
+        glm::vec4 ndc((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, 0.0f, 1.0f);
+        glm::vec4 world = inverse * ndc;
+        glm::vec2 point = glm::vec2(world) / world.w;
+
+        bounds.min = corner == 0 ? point : glm::min(bounds.min, point);
+        bounds.max = corner == 0 ? point : glm::max(bounds.max, point);
+    }
+    return bounds;
+}
+
+void Graphics::addInstancedShape(std::shared_ptr<InstancedShape> shape) {
+    if (!shape || !shape->mesh) return;
+    shape->mesh->setVertexFormat(m_batch.getFormat());
+    instancedShapes.push_back(shape);
+    m_queue.add(shape.get(), shape->depth);
+}
+
+bool Graphics::removeInstancedShape(const std::shared_ptr<InstancedShape>& shape) {
+    auto it = std::find(instancedShapes.begin(), instancedShapes.end(), shape);
+    if (it == instancedShapes.end()) return false;
+
+    m_queue.remove(static_cast<const void*>(shape.get()));
+    instancedShapes.erase(it);
+    return true;
+}
+
+void Graphics::setVertexFormat(VertexFormat format) {
+    m_batch.setFormat(format);
+    for (auto& shape : shapes) {
+        shape->setVertexFormat(format);
+    }
+    for (auto& group : instancedShapes) {
+        group->mesh->setVertexFormat(format);
+    }
+}
+
+VertexFormat Graphics::getVertexFormat() const {
+    return m_batch.getFormat();
 }
 
 void Graphics::addLight(std::shared_ptr<LightSource> source) {
@@ -352,99 +1061,626 @@ void Graphics::addLight(std::shared_ptr<LightSource> source) {
     }
 
     lights.push_back(source);
+    m_queue.add(source.get(), source->depth);
 }
 
-void Graphics::render() {
-    glm::mat4 view = m_camera.getViewMatrix();
-    glm::mat4 projection = m_projection;
+bool Graphics::removeLight(const std::shared_ptr<LightSource>& source) {
+    auto it = std::find(lights.begin(), lights.end(), source);
+    if (it == lights.end()) return false;
 
-    // Clear screen
-    clear(0, 0, 0, 1);
+    m_queue.remove(static_cast<const void*>(source.get()));
+    lights.erase(it);
+    return true;
+}
+
+void Graphics::setRenderMode(RenderMode mode) {
+    m_renderMode = mode;
+}
+
+RenderMode Graphics::getRenderMode() const {
+    return m_renderMode;
+}
+
+const RenderStats& Graphics::getStats() const {
+    return m_stats;
+}
+
+void Graphics::renderLightGlow(const LightSource& light) {
+    queueGlow(light, getViewBounds());
+    flushGlows();
+}
+
+void Graphics::queueGlow(const LightSource& light, const AABB& view) {
+    if (light.type != LightType::Directional && light.type != LightType::Point) return;
 
-    // Combine shapes and lights into one sorted list
-    struct RenderItem {
-        enum class Kind { Light, Shape } kind;
-        float depth;
-        std::shared_ptr<LightSource> light;
-        std::shared_ptr<Shape> shape;
-    };
+    // The radius bounds every cone, skip glows that are off screen
+    glm::vec2 extent(light.radius);
+    if (light.radius <= 0.0f || !view.intersects(AABB{ light.position - extent, light.position + extent })) return;
 
-    std::vector<RenderItem> items;
+    m_glowInstances.push_back({
+        glm::vec4(light.position, light.radius, m_shadows.rowCoord(light)),
+        glm::vec4(light.direction, light.cutoff, 0.0f),
+        glm::vec4(light.color, light.intensity)
+    });
+}
+
+void Graphics::flushGlows() {
+    if (m_glowInstances.empty()) return;
+
+    if (!m_glowVAO) {
+        glGenVertexArrays(1, &m_glowVAO);
+        glBindVertexArray(m_glowVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_cornerVBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        for (GLuint location = 1; location <= 3; ++location) {
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+    }
+
+    GpuPass previousPass = m_profiler.switchGpuPass(GpuPass::Lights);
+    bindProgram(*m_glowProgram);
+    glBindVertexArray(m_glowVAO);
+
+    size_t base = m_stream.write(m_glowInstances.data(), m_glowInstances.size() * sizeof(GlowInstance),
+                                 sizeof(GlowInstance));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(GlowInstance), (void*)(base + offsetof(GlowInstance, light)));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(GlowInstance), (void*)(base + offsetof(GlowInstance, direction)));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(GlowInstance), (void*)(base + offsetof(GlowInstance, color)));
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(m_glowInstances.size()));
+    glBindVertexArray(0);
+
+    m_glowInstances.clear();
+    m_stats.drawCalls++;
+    m_profiler.switchGpuPass(previousPass);
+}
+
+bool Graphics::loadFont(const unsigned char* fontBuffer, int fontBufferSize, float pixelHeight, FontMode mode) {
+    return m_font.load(fontBuffer, fontBufferSize, pixelHeight, mode);
+}
 
+bool Graphics::loadFont(const std::string& path, float pixelHeight, FontMode mode) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open font: " << path << std::endl;
+        return false;
+    }
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return m_font.load(data.data(), static_cast<int>(data.size()), pixelHeight, mode);
+}
+
+void Graphics::setTextStyle(const TextStyle& style) {
+    m_textStyle = style;
+}
+
+const TextStyle& Graphics::getTextStyle() const {
+    return m_textStyle;
+}
+
+Font& Graphics::getFont() {
+    return m_font;
+}
+
+void Graphics::renderText(const std::string& text, const glm::vec2& position, float scale,
+                          glm::vec3 color, float rotationDegrees) {
+    queueText(text, position, scale, glm::vec4(color, 1.0f), rotationDegrees, false);
+}
+
+void Graphics::renderScreenText(const std::string& text, const glm::vec2& position, float scale, glm::vec3 color) {
+    queueText(text, position, scale, glm::vec4(color, 1.0f), 0.0f, true);
+}
+
+glm::vec2 Graphics::measureText(const std::string& text, float scale) {
+    if (!m_font.loaded() || text.empty()) return glm::vec2(0.0f);
+
+    float width = 0.0f;
+    float lineWidth = 0.0f;
+    int lines = 1;
+    const Glyph* previous = nullptr;
+    for (size_t i = 0; i < text.size();) {
+        uint32_t codepoint = Font::decodeUtf8(text, i);
+        if (codepoint == '\n') {
+            width = std::max(width, lineWidth);
+            lineWidth = 0.0f;
+            previous = nullptr;
+            lines++;
+            continue;
+        }
+        const Glyph& glyph = m_font.glyph(codepoint);
+        if (previous) lineWidth += m_font.kerning(*previous, glyph);
+        lineWidth += glyph.advance;
+        previous = &glyph;
+    }
+    width = std::max(width, lineWidth);
+
+    float height = m_font.ascent() - m_font.descent() + (lines - 1) * m_font.lineHeight();
+    return glm::vec2(width, height) * scale;
+}
+
+void Graphics::queueText(const std::string& text, const glm::vec2& position, float scale, const glm::vec4& color,
+                         float rotationDegrees, bool screenSpace) {
+    if (!m_font.loaded()) return;
+
+    float radians = glm::radians(rotationDegrees);
+    glm::vec2 right(std::cos(radians), std::sin(radians));
+    glm::vec2 up(-right.y, right.x);
+    float space = screenSpace ? 1.0f : 0.0f;
+
+    // The quad only reaches sdfSpread() past the glyph edge
+    float spread = m_font.sdfSpread();
+    glm::vec4 outline(m_textStyle.outlineColor, std::min(std::max(m_textStyle.outlineWidth, 0.0f), spread));
+    glm::vec4 glow(m_textStyle.glowColor, std::min(std::max(m_textStyle.glowRadius, 0.0f), spread));
+
+    // Pen position in the string's own, unrotated frame
+    glm::vec2 pen(0.0f);
+    const Glyph* previous = nullptr;
+
+    for (size_t i = 0; i < text.size();) {
+        uint32_t codepoint = Font::decodeUtf8(text, i);
+        if (codepoint == '\n') {
+            pen = glm::vec2(0.0f, pen.y - m_font.lineHeight());
+            previous = nullptr;
+            continue;
+        }
+
+        const Glyph& glyph = m_font.glyph(codepoint);
+        if (previous) pen.x += m_font.kerning(*previous, glyph);
+
+        if (glyph.width > 0) {
+            glm::vec2 corner = (pen + glyph.offset) * scale;
+            glm::vec2 size = glm::vec2(glyph.width, glyph.height) * scale;
+            m_textInstances.push_back({
+                glm::vec4(position + right * corner.x + up * corner.y, right * size.x),
+                glm::vec4(up * size.y, space, 0.0f),
+                glm::vec4(glyph.x, glyph.y, glyph.width, glyph.height),
+                color,
+                outline,
+                glow
+            });
+        }
+
+        pen.x += glyph.advance;
+        previous = &glyph;
+    }
+}
+
+void Graphics::flushText() {
+    if (m_textInstances.empty()) return;
+
+    // Glyphs rasterized while queueing this frame's text; the upload binds the atlas itself
+    size_t uploaded = m_font.upload();
+    m_stats.uploadedBytes += uploaded;
+    if (uploaded > 0) currentTexture = 0;
+
+    if (!m_textVAO) {
+        glGenVertexArrays(1, &m_textVAO);
+        glBindVertexArray(m_textVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_cornerVBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        for (GLuint location = 1; location <= 6; ++location) {
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+    }
+
+    const ShaderProgram& program = m_font.mode() == FontMode::SDF ? *m_textSdfProgram : *m_textProgram;
+    bindProgram(program);
+    glm::ivec2 atlas = m_font.atlasSize();
+    glUniform2f(program.location("uAtlasSize"), static_cast<float>(atlas.x), static_cast<float>(atlas.y));
+    glUniform2f(program.location("uScreenSize"), static_cast<float>(m_windowWidth), static_cast<float>(m_windowHeight));
+    if (m_font.mode() == FontMode::SDF) {
+        glUniform1f(program.location("uSdfSpread"), m_font.sdfSpread());
+    }
+    bindTexture(m_font.texture());
+    glBindVertexArray(m_textVAO);
+
+    size_t base = m_stream.write(m_textInstances.data(), m_textInstances.size() * sizeof(TextInstance),
+                                 sizeof(TextInstance));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(TextInstance), (void*)(base + offsetof(TextInstance, position)));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(TextInstance), (void*)(base + offsetof(TextInstance, up)));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(TextInstance), (void*)(base + offsetof(TextInstance, glyph)));
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(TextInstance), (void*)(base + offsetof(TextInstance, color)));
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(TextInstance), (void*)(base + offsetof(TextInstance, outline)));
+    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(TextInstance), (void*)(base + offsetof(TextInstance, glow)));
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(m_textInstances.size()));
+    glBindVertexArray(0);
+
+    m_stats.drawCalls++;
+    m_stats.vertices += static_cast<int>(m_textInstances.size() * 4);
+    m_textInstances.clear();
+}
+
+void Graphics::renderDeferredLights(GLuint target, const GLint viewport[4]) {
+    if (!m_lightQuadVAO) {
+        glGenVertexArrays(1, &m_lightQuadVAO);
+        glBindVertexArray(m_lightQuadVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_cornerVBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(1, 1);
+        glVertexAttribDivisor(2, 1);
+        glBindVertexArray(0);
+
+        // The composite triangle is generated from gl_VertexID
+        glGenVertexArrays(1, &m_compositeVAO);
+    }
+
+    // Ambient and directional lights are uniform over the plane, so they
+    // become the clear color and only point lights are drawn
+    glm::vec3 ambient(0.0f);
+    AABB view = getViewBounds();
+    m_lightInstances.clear();
     for (const auto& light : lights) {
-        if (light) {
-            items.push_back({ RenderItem::Kind::Light, light->depth, light, nullptr });
+        glm::vec3 color = light->color * light->intensity;
+        if (light->type != LightType::Point) {
+            ambient += color;
+            continue;
         }
+
+        glm::vec2 extent(light->radius);
+        if (light->radius <= 0.0f || !view.intersects(AABB{ light->position - extent, light->position + extent })) continue;
+        m_lightInstances.push_back({
+            glm::vec4(light->position, light->radius, m_shadows.rowCoord(*light)),
+            glm::vec4(color, 0.0f)
+        });
     }
 
-    for (const auto& shape : shapes) {
-        if (shape && shape->isVisible) {
-            items.push_back({RenderItem::Kind::Shape, shape->depth, nullptr, shape});
+    m_gbuffer.beginLights(ambient);
+
+    if (!m_lightInstances.empty()) {
+        bindProgram(*m_deferredLightProgram);
+        glBlendFunc(GL_ONE, GL_ONE);
+
+        glBindVertexArray(m_lightQuadVAO);
+        size_t base = m_stream.write(m_lightInstances.data(), m_lightInstances.size() * sizeof(LightInstance),
+                                     sizeof(LightInstance));
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(LightInstance), (void*)(base + offsetof(LightInstance, light)));
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(LightInstance), (void*)(base + offsetof(LightInstance, color)));
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(m_lightInstances.size()));
+        glBindVertexArray(0);
+
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        m_stats.drawCalls++;
+    }
+
+    // Composite into the framebuffer that was bound when render() started
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glDisable(GL_BLEND);
+
+    bindProgram(*m_compositeProgram);
+    glActiveTexture(GL_TEXTURE0 + lightTextureUnit);
+    glBindTexture(GL_TEXTURE_2D, m_gbuffer.light());
+    bindTexture(m_gbuffer.albedo());
+
+    glBindVertexArray(m_compositeVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glEnable(GL_BLEND);
+    m_stats.drawCalls++;
+}
+
+const ShaderProgram* Graphics::programFor(const Shape& shape) const {
+    if (shape.shaderName == "default") return m_defaultProgram;
+    const ShaderProgram* program = findProgram(shape.shaderName);
+    return program ? program : m_defaultProgram;
+}
+
+void Graphics::batchShape(Shape& shape, const glm::mat4& viewProjection) {
+    const ShaderProgram* program = programFor(shape);
+    GLuint texture = shape.texture.getData();
+    GLenum mode = SpriteBatch::batchMode(shape.type);
+
+    if (!m_batch.empty() && !m_batch.accepts(program, texture, mode)) {
+        flushBatch(viewProjection);
+    }
+    if (m_batch.empty()) {
+        m_batch.begin(program, texture, mode);
+    }
+
+    m_batch.append(shape);
+    m_stats.shapes++;
+}
+
+void Graphics::flushBatch(const glm::mat4& viewProjection) {
+    if (m_batch.empty()) return;
+
+    const ShaderProgram& program = *m_batch.getProgram();
+    bindProgram(program);
+
+    // Vertices are already in world space
+    glm::mat4 identity = glm::mat4(1.0f);
+    glUniformMatrix4fv(program.location(UniformID::Model), 1, GL_FALSE, &identity[0][0]);
+    // Custom shaders may still take the combined matrix as a plain uniform
+    glUniformMatrix4fv(program.location(UniformID::MVP), 1, GL_FALSE, &viewProjection[0][0]);
+    glUniform4f(program.location(UniformID::Tint), 1.0f, 1.0f, 1.0f, 1.0f);
+    glUniform4f(program.location(UniformID::UVRect), 0.0f, 0.0f, 1.0f, 1.0f);
+
+    bindTexture(m_batch.getTexture());
+    m_stats.vertices += m_batch.flush();
+    m_stats.drawCalls++;
+}
+
+void Graphics::setInstancingThreshold(int minShapes) {
+    m_instancingThreshold = minShapes;
+}
+
+bool Graphics::canInstance(const Shape& a, const Shape& b) {
+    return !a.dynamic && !b.dynamic && a.getVAO() == b.getVAO() && a.type == b.type && a.shaderName == b.shaderName
+        && a.vertices.size() == b.vertices.size() && a.indices.size() == b.indices.size()
+        && a.texture.getData() == b.texture.getData();
+}
+
+void Graphics::drawInstanced(Shape& mesh, const InstanceData* data, size_t count) {
+    if (count == 0 || mesh.vertices.empty()) return;
+
+    bindProgram(*m_instancedProgram);
+
+    bindTexture(mesh.texture.getData());
+
+    glBindVertexArray(mesh.getVAO());
+    size_t base = m_stream.write(data, count * sizeof(InstanceData), sizeof(glm::vec4));
+
+    // The mesh VAO keeps its per-vertex attributes, per-instance ones are attached here
+    for (int column = 0; column < 4; ++column) {
+        GLuint location = 3 + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                              (void*)(base + offsetof(InstanceData, model) + sizeof(glm::vec4) * column));
+        glVertexAttribDivisor(location, 1);
+    }
+
+    glEnableVertexAttribArray(7);
+    glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(base + offsetof(InstanceData, tint)));
+    glVertexAttribDivisor(7, 1);
+
+    glEnableVertexAttribArray(8);
+    glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(base + offsetof(InstanceData, uvRect)));
+    glVertexAttribDivisor(8, 1);
+
+    if (!mesh.indices.empty()) {
+        glDrawElementsInstanced(mesh.drawMode(), (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, nullptr, (GLsizei)count);
+    } else {
+        glDrawArraysInstanced(mesh.drawMode(), 0, (GLsizei)mesh.vertices.size(), (GLsizei)count);
+    }
+
+    glBindVertexArray(0);
+
+    m_stats.drawCalls++;
+    m_stats.shapes += static_cast<int>(count);
+    m_stats.vertices += static_cast<int>(mesh.vertices.size() * count);
+}
+
+void Graphics::drawDynamic(Shape& shape, const glm::mat4& view, const glm::mat4& projection, const ShaderProgram& program) {
+    if (!shape.isVisible || shape.vertices.empty()) return;
+
+    shape.applyUniforms(view, projection, program);
+    m_batch.drawShape(shape);
+}
+
+void Graphics::render() {
+    // Standalone calls get a profiler frame of their own; Obsidian::run opens one per loop
+    bool ownsFrame = m_profiler.isEnabled() && !m_profiler.inFrame();
+    if (ownsFrame) m_profiler.beginFrame();
+
+    {
+        Profiler::CpuScope scope(m_profiler, "Graphics::render");
+        renderFrame();
+    }
+
+    if (ownsFrame) m_profiler.endFrame();
+}
+
+void Graphics::renderFrame() {
+    glm::mat4 view = m_camera.getViewMatrix();
+    glm::mat4 projection = m_projection;
+    glm::mat4 viewProjection = projection * view;
+
+    m_stats = RenderStats();
+    m_stream.beginFrame();
+
+    // Finish some pending async texture uploads before anything samples them
+    m_loader.update(m_uploadBudgetMs);
+    // Geometry and textures of shapes dropped since the last frame, on whichever thread
+    m_meshes.collect();
+    m_textures.collect();
+
+    // Clear screen
+    m_profiler.switchGpuPass(GpuPass::Clear);
+    clear(0, 0, 0, 1);
+    m_profiler.switchGpuPass(GpuPass::Count);
+
+    m_visibleShapes.clear();
+    if (m_culling) {
+        m_grid.query(getViewBounds(), m_visibleShapes);
+        m_stats.culled = static_cast<int>(shapes.size() - m_visibleShapes.size());
+    } else {
+        for (const auto& shape : shapes) {
+            m_visibleShapes.push_back(shape.get());
         }
     }
 
-    std::sort(items.begin(), items.end(), [](const RenderItem& a, const RenderItem& b) {
-        if (a.depth != b.depth)
-            return a.depth < b.depth;
-        return a.kind == RenderItem::Kind::Light && b.kind == RenderItem::Kind::Shape;
+    m_visibleShapes.erase(std::remove_if(m_visibleShapes.begin(), m_visibleShapes.end(),
+                                         [](const Shape* shape) { return !shape->isVisible; }),
+                          m_visibleShapes.end());
+
+    // Text meshes follow font reloads and atlas growth before anything samples the atlas
+    for (Shape* shape : m_visibleShapes) {
+        if (shape->m_isText) m_stats.uploadedBytes += static_cast<TextMesh*>(shape)->refresh();
+    }
+
+    // Keys are refreshed every frame, so depth, shader or texture changes
+    // (including async texture swaps) only cost a few insertion sort moves
+    m_queue.update(m_visibleShapes, [this](const RenderItem& item) {
+        switch (item.kind) {
+            case RenderItem::Kind::Light:
+                return RenderQueue::makeKey(item.light->depth, item.kind, 0, 0, 0);
+            case RenderItem::Kind::Instanced: {
+                const Shape& mesh = *item.instanced->mesh;
+                return RenderQueue::makeKey(item.instanced->depth, item.kind, m_instancedProgram->id,
+                                            mesh.texture.getData(), mesh.getVAO());
+            }
+            case RenderItem::Kind::Shape:
+                break;
+        }
+        const Shape& shape = *item.shape;
+        return RenderQueue::makeKey(shape.depth, item.kind, programFor(shape)->id,
+                                    shape.texture.getData(), shape.getVAO());
     });
+    m_stats.sortMoves = m_queue.lastSortMoves();
 
-    // Shader handles
-    GLuint quadShader = shaderPrograms["fullscreenQuad"];
-    GLuint defaultShader = shaderPrograms["default"];
+    const std::vector<RenderItem>& items = m_queue.items();
 
-    // Set light uniforms once for shapes
-    useShader("default");
-    GLint numLightsLoc = glGetUniformLocation(defaultShader, "uNumLights");
-    glUniform1i(numLightsLoc, static_cast<int>(lights.size()));
+    bool deferred = m_lightingMode == LightingMode::Deferred;
 
-    for (int i = 0; i < lights.size(); ++i) {
-        const auto& light = lights[i];
-        std::string base = "uLights[" + std::to_string(i) + "]";
-        glm::vec3 pos3 = glm::vec3(light->position, 0.0f);
-        glm::vec3 dir3 = glm::vec3(light->direction, 0.0f);
+    bool tiled = m_lightingMode == LightingMode::Tiled;
+
+    // Redraw stale shadow rows first, the light buffers refer to their rows.
+    // Only the plain forward path is bound by the light budget.
+    size_t lightCount = m_lightingMode == LightingMode::Forward
+        ? std::min(lights.size(), static_cast<size_t>(m_lightBudget)) : lights.size();
+    m_profiler.switchGpuPass(GpuPass::Shadows);
+    m_stats.shadowUpdates = m_shadows.update(lights, lightCount, m_grid, m_stream, *m_shadowProgram);
+    m_profiler.switchGpuPass(GpuPass::Count);
+    if (m_stats.shadowUpdates > 0) {
+        currentProgram = 0;  // The shadow pass bound its own program
+    }
+    if (m_shadows.texture()) {
+        glActiveTexture(GL_TEXTURE0 + shadowTextureUnit);
+        glBindTexture(GL_TEXTURE_2D, m_shadows.texture());
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // Shared by every program through the FrameData / Lights binding points
+    updateFrameBuffer(view, projection);
+    if (tiled) {
+        m_stats.uploadedBytes += m_lightGrid.update(lights, m_shadows, viewProjection, m_windowWidth, m_windowHeight);
+        m_lightGrid.bind(lightDataUnit, lightTilesUnit);
+    } else {
+        updateLightBuffer();
+    }
 
-        glUniform1i(glGetUniformLocation(defaultShader, (base + ".type").c_str()), static_cast<int>(light->type));
-        glUniform3fv(glGetUniformLocation(defaultShader, (base + ".position").c_str()), 1, &pos3[0]);
-        glUniform3fv(glGetUniformLocation(defaultShader, (base + ".direction").c_str()), 1, &dir3[0]);
-        glUniform3fv(glGetUniformLocation(defaultShader, (base + ".color").c_str()), 1, &light->color[0]);
-        glUniform1f(glGetUniformLocation(defaultShader, (base + ".intensity").c_str()), light->intensity);
-        glUniform1f(glGetUniformLocation(defaultShader, (base + ".cutoff").c_str()), light->cutoff);
+    // Deferred: shapes write unlit albedo into the G-buffer, lit and composited below
+    GLint target = 0;
+    GLint viewport[4];
+    if (deferred) {
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &target);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        deferred = m_gbuffer.resize(m_windowWidth, m_windowHeight);
+        if (deferred) m_gbuffer.beginGeometry();
     }
 
+    AABB viewBounds = getViewBounds();
+
+    // Texture uploads, shadow and G-buffer setup above (and any GL work done
+    // between frames) may have left another texture on unit 0
+    currentTexture = 0;
+
     // Draw all items sorted by depth
-    for (const auto& item : items) {
-        if (item.kind == RenderItem::Kind::Light) {
-            const auto& light = item.light;
-            if (light->type != LightType::Directional && light->type != LightType::Point) continue;
+    m_profiler.switchGpuPass(GpuPass::Shapes);
+    for (size_t i = 0; i < items.size(); ++i) {
+        const auto& item = items[i];
 
-            useShader("fullscreenQuad");
+        // Consecutive lights share one instanced glow draw
+        if (item.kind != RenderItem::Kind::Light) {
+            flushGlows();
+        }
 
-            glm::mat4 model = glm::mat4(1.0f);
-            glm::mat4 mvp = projection * view * model;
+        if (item.kind == RenderItem::Kind::Light) {
+            // Deferred glows go on top of the composited image instead
+            if (deferred) continue;
 
-            glUniformMatrix4fv(glGetUniformLocation(quadShader, "uModel"), 1, GL_FALSE, &model[0][0]);
-            glUniformMatrix4fv(glGetUniformLocation(quadShader, "uMVP"), 1, GL_FALSE, &mvp[0][0]);
+            flushBatch(viewProjection);
+            queueGlow(*item.light, viewBounds);
 
-            glUniform2fv(glGetUniformLocation(quadShader, "uLightPos"), 1, &light->position[0]);
-            glUniform2fv(glGetUniformLocation(quadShader, "uLightDir"), 1, &light->direction[0]);
-            glUniform1f(glGetUniformLocation(quadShader, "uCutoff"), light->cutoff);
-            glUniform3fv(glGetUniformLocation(quadShader, "uLightColor"), 1, &light->color[0]);
-            glUniform1f(glGetUniformLocation(quadShader, "uIntensity"), light->intensity);
-            glUniform1f(glGetUniformLocation(quadShader, "uRadius"), light->radius);
+        } else if (item.kind == RenderItem::Kind::Instanced) {
+            const auto& group = item.instanced;
+            if (!group->isVisible || group->instances.empty()) continue;
 
-            glBindVertexArray(fullscreenQuadVAO);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-            glBindVertexArray(0);
+            flushBatch(viewProjection);
+            drawInstanced(*group->mesh, group->instances.data(), group->instances.size());
 
         } else if (item.kind == RenderItem::Kind::Shape) {
             const auto& shape = item.shape;
-            useShader("default");
 
-            GLint modelLoc = glGetUniformLocation(defaultShader, "uModel");
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &shape->modelMatrix[0][0]);
+            // Collapse a run of shapes sharing one mesh into a single instanced draw.
+            // Only the default shader has an instanced variant.
+            if (m_instancingThreshold > 0 && shape->shaderName == "default") {
+                size_t end = i + 1;
+                while (end < items.size() && items[end].kind == RenderItem::Kind::Shape
+                       && canInstance(*shape, *items[end].shape)) {
+                    ++end;
+                }
+
+                if (end - i >= static_cast<size_t>(m_instancingThreshold)) {
+                    m_instanceScratch.clear();
+                    for (size_t j = i; j < end; ++j) {
+                        const Shape& s = *items[j].shape;
+                        m_instanceScratch.push_back({ s.getModelMatrix(), s.tint, s.uvRect });
+                    }
+
+                    flushBatch(viewProjection);
+                    drawInstanced(*shape, m_instanceScratch.data(), m_instanceScratch.size());
+                    i = end - 1;
+                    continue;
+                }
+            }
+
+            if (m_renderMode == RenderMode::Batched) {
+                batchShape(*shape, viewProjection);
+                continue;
+            }
+
+            const ShaderProgram& program = *programFor(*shape);
+            bindProgram(program);
+            // Shape::applyUniforms binds it again; this keeps the cache and stats right
+            bindTexture(shape->texture.getData());
+
+            if (shape->dynamic) {
+                drawDynamic(*shape, view, projection, program);
+            } else {
+                shape->draw(view, projection, program);
+            }
+            m_stats.drawCalls++;
+            m_stats.shapes++;
+            m_stats.vertices += static_cast<int>(shape->vertices.size());
+        }
+    }
+
+    flushBatch(viewProjection);
+    flushGlows();
 
-            shape->draw(view, projection, defaultShader);
+    if (deferred) {
+        m_profiler.switchGpuPass(GpuPass::Lights);
+        renderDeferredLights(static_cast<GLuint>(target), viewport);
+        for (const auto& item : items) {
+            if (item.kind == RenderItem::Kind::Light) queueGlow(*item.light, viewBounds);
         }
+        flushGlows();
     }
+
+    // Text goes on top of the lit scene
+    m_profiler.switchGpuPass(GpuPass::Text);
+    flushText();
+
+    m_profiler.switchGpuPass(GpuPass::Count);
+
+    m_stream.endFrame();
+    m_stats.streamedBytes = m_stream.stats().bytes;
+    m_stats.streamStalls = m_stream.stats().stalls;
+
+    size_t textureBytes = m_loader.progress().bytesUploaded;
+    m_stats.uploadedBytes += m_stats.streamedBytes + (textureBytes - m_loaderBytes);
+    m_loaderBytes = textureBytes;
+
+    m_profiler.setCounters({ m_stats.drawCalls, m_stats.stateChanges, m_stats.vertices, m_stats.uploadedBytes });
+}
+
+Profiler& Graphics::getProfiler() {
+    return m_profiler;
 }
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "../../include/includes.h"
+
+LightGrid::~LightGrid() {
+    destroy();
+}
+
+void LightGrid::destroy() {
+    GLuint textures[] = { m_dataTexture, m_tileTexture };
+    GLuint buffers[] = { m_dataBuffer, m_tileBuffer };
+    if (m_dataTexture) glDeleteTextures(2, textures);
+    if (m_dataBuffer) glDeleteBuffers(2, buffers);
+
+    m_dataTexture = m_tileTexture = 0;
+    m_dataBuffer = m_tileBuffer = 0;
+    m_uploadedData.clear();
+    m_uploadedTiles.clear();
+}
+
+void LightGrid::upload(GLuint buffer, const void* data, size_t bytes) {
+    // Orphan and refill; the lists are small and usually change with the camera
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(bytes), data, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+size_t LightGrid::update(const std::vector<std::shared_ptr<LightSource>>& lights, const ShadowMap& shadows,
+                       const glm::mat4& viewProjection, int width, int height) {
+    if (!m_dataBuffer) {
+        glGenBuffers(1, &m_dataBuffer);
+        glGenBuffers(1, &m_tileBuffer);
+        glGenTextures(1, &m_dataTexture);
+        glGenTextures(1, &m_tileTexture);
+    }
+
+    int tilesX = (std::max(width, 1) + m_tileSize - 1) / m_tileSize;
+    int tilesY = (std::max(height, 1) + m_tileSize - 1) / m_tileSize;
+    size_t tileCount = static_cast<size_t>(tilesX) * tilesY;
+
+    glm::vec3 ambient(0.0f);
+    m_data.assign(2, glm::vec4(0.0f));
+    m_rects.clear();
+
+    for (const auto& light : lights) {
+        glm::vec3 color = light->color * light->intensity;
+        if (light->type != LightType::Point) {
+            // Same over the whole plane, no need to bin
+            ambient += color;
+            continue;
+        }
+        if (light->radius <= 0.0f) continue;
+
+        // Screen rectangle of the light's bounds, in tiles
+        glm::vec2 lo(std::numeric_limits<float>::max());
+        glm::vec2 hi(std::numeric_limits<float>::lowest());
+        for (int corner = 0; corner < 4; ++corner) {
+            glm::vec2 offset((corner & 1) ? light->radius : -light->radius,
+                             (corner & 2) ? light->radius : -light->radius);
+            glm::vec4 clip = viewProjection * glm::vec4(light->position + offset, 0.0f, 1.0f);
+            glm::vec2 pixel = (glm::vec2(clip) / clip.w * 0.5f + 0.5f) * glm::vec2(width, height);
+            lo = glm::min(lo, pixel);
+            hi = glm::max(hi, pixel);
+        }
+
+        glm::ivec4 rect(static_cast<int>(std::floor(lo.x / m_tileSize)), static_cast<int>(std::floor(lo.y / m_tileSize)),
+                        static_cast<int>(std::floor(hi.x / m_tileSize)), static_cast<int>(std::floor(hi.y / m_tileSize)));
+        if (rect.z < 0 || rect.w < 0 || rect.x >= tilesX || rect.y >= tilesY) continue;  // Off screen
+
+        m_rects.push_back(glm::clamp(rect, glm::ivec4(0), glm::ivec4(tilesX - 1, tilesY - 1, tilesX - 1, tilesY - 1)));
+        m_data.push_back(glm::vec4(light->position, light->radius, shadows.rowCoord(*light)));
+        m_data.push_back(glm::vec4(color, 0.0f));
+    }
+
+    m_data[0] = glm::vec4(ambient, static_cast<float>(tilesX));
+    m_data[1] = glm::vec4(static_cast<float>(m_tileSize), 0.0f, 0.0f, 0.0f);
+    m_lightCount = m_rects.size();
+
+    // Counting sort into per-tile lists: count, prefix sum, fill
+    size_t header = tileCount * 2;
+    m_tiles.assign(header, 0);
+    for (const auto& rect : m_rects) {
+        for (int y = rect.y; y <= rect.w; ++y) {
+            for (int x = rect.x; x <= rect.z; ++x) {
+                m_tiles[(static_cast<size_t>(y) * tilesX + x) * 2 + 1]++;
+            }
+        }
+    }
+
+    GLint next = static_cast<GLint>(header);
+    for (size_t tile = 0; tile < tileCount; ++tile) {
+        m_tiles[tile * 2] = next;
+        next += m_tiles[tile * 2 + 1];
+        m_tiles[tile * 2 + 1] = 0;
+    }
+    m_entries = static_cast<size_t>(next) - header;
+    m_tiles.resize(static_cast<size_t>(next));
+
+    for (size_t light = 0; light < m_rects.size(); ++light) {
+        const auto& rect = m_rects[light];
+        for (int y = rect.y; y <= rect.w; ++y) {
+            for (int x = rect.x; x <= rect.z; ++x) {
+                size_t tile = (static_cast<size_t>(y) * tilesX + x) * 2;
+                m_tiles[m_tiles[tile] + m_tiles[tile + 1]++] = static_cast<GLint>(light);
+            }
+        }
+    }
+
+    // A static camera over static lights re-uploads nothing
+    size_t uploaded = 0;
+    if (m_data != m_uploadedData) {
+        uploaded += m_data.size() * sizeof(glm::vec4);
+        upload(m_dataBuffer, m_data.data(), m_data.size() * sizeof(glm::vec4));
+        glBindTexture(GL_TEXTURE_BUFFER, m_dataTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_dataBuffer);
+        m_uploadedData.swap(m_data);
+    }
+    if (m_tiles != m_uploadedTiles) {
+        uploaded += m_tiles.size() * sizeof(GLint);
+        upload(m_tileBuffer, m_tiles.data(), m_tiles.size() * sizeof(GLint));
+        glBindTexture(GL_TEXTURE_BUFFER, m_tileTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32I, m_tileBuffer);
+        m_uploadedTiles.swap(m_tiles);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    return uploaded;
+}
+
+void LightGrid::bind(GLint dataUnit, GLint tileUnit) const {
+    glActiveTexture(GL_TEXTURE0 + dataUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, m_dataTexture);
+    glActiveTexture(GL_TEXTURE0 + tileUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, m_tileTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,79 @@
+#include "../../include/includes.h"
+
+static MeshRegistry* activeRegistry = nullptr;
+
+MeshResource::~MeshResource() {
+    if (registry) {
+        std::lock_guard<std::mutex> lock(registry->mutex);
+        // The context is gone once Graphics shut down; nothing left to free
+        if (!registry->contextAlive) return;
+
+        if (vao) registry->vertexArrays.push_back(vao);
+        if (vbo) registry->buffers.push_back(vbo);
+        if (ebo) registry->buffers.push_back(ebo);
+        return;
+    }
+
+    if (vao) glDeleteVertexArrays(1, &vao);
+    if (vbo) glDeleteBuffers(1, &vbo);
+    if (ebo) glDeleteBuffers(1, &ebo);
+}
+
+MeshRegistry::~MeshRegistry() {
+    shutdown();
+}
+
+MeshRegistry* MeshRegistry::active() {
+    return activeRegistry;
+}
+
+void MeshRegistry::initialize() {
+    if (!m_state) {
+        m_state = std::make_shared<MeshRegistryState>();
+    }
+    m_state->contextAlive = true;
+    activeRegistry = this;
+}
+
+void MeshRegistry::shutdown() {
+    if (m_state) {
+        collect();
+
+        // Meshes still held by the application must not touch GL after this point
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->contextAlive = false;
+        m_state.reset();
+    }
+    if (activeRegistry == this) {
+        activeRegistry = nullptr;
+    }
+}
+
+std::shared_ptr<MeshResource> MeshRegistry::create() {
+    auto mesh = std::make_shared<MeshResource>();
+    glGenVertexArrays(1, &mesh->vao);
+    glGenBuffers(1, &mesh->vbo);
+
+    if (activeRegistry) {
+        mesh->registry = activeRegistry->m_state;
+    }
+    return mesh;
+}
+
+size_t MeshRegistry::collect() {
+    if (!m_state) return 0;
+
+    {
+        // Swapping keeps both lists' capacity, steady despawning does not allocate
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_vertexArrays.swap(m_state->vertexArrays);
+        m_buffers.swap(m_state->buffers);
+    }
+
+    size_t count = m_vertexArrays.size() + m_buffers.size();
+    if (!m_vertexArrays.empty()) glDeleteVertexArrays(static_cast<GLsizei>(m_vertexArrays.size()), m_vertexArrays.data());
+    if (!m_buffers.empty()) glDeleteBuffers(static_cast<GLsizei>(m_buffers.size()), m_buffers.data());
+    m_vertexArrays.clear();
+    m_buffers.clear();
+    return count;
+}
@@ -0,0 +1,218 @@
+#include "../../include/includes.h"
+#include <fstream>
+#include <iomanip>
+
+// Scope names are arbitrary strings, trace files must stay valid JSON
+static std::string jsonEscape(const std::string& text) {
+    static const char* hex = "0123456789abcdef";
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (byte < 0x20) {
+            out += "\\u00";
+            out += hex[byte >> 4];
+            out += hex[byte & 0xF];
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+Profiler::Profiler()
+    : m_origin(std::chrono::steady_clock::now()) {
+}
+
+Profiler::~Profiler() {
+    destroy();
+}
+
+void Profiler::destroy() {
+    if (m_activePass != GpuPass::Count) {
+        glEndQuery(GL_TIME_ELAPSED);
+        m_activePass = GpuPass::Count;
+    }
+    for (auto& slot : m_gpuFrames) {
+        if (!slot.queries.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(slot.queries.size()), slot.queries.data());
+        }
+        slot = GpuFrame();
+    }
+    m_inFrame = false;
+}
+
+void Profiler::setEnabled(bool enabled) {
+    if (!enabled && m_inFrame) endFrame();
+    m_enabled = enabled;
+}
+
+void Profiler::setHistorySize(size_t frames) {
+    m_historySize = std::max<size_t>(frames, 1);
+    while (m_history.size() > m_historySize) m_history.pop_front();
+}
+
+double Profiler::nowUs() const {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_origin).count();
+}
+
+FrameProfile* Profiler::find(uint64_t frame) {
+    if (m_history.empty() || frame < m_history.front().frame || frame > m_history.back().frame) return nullptr;
+    return &m_history[static_cast<size_t>(frame - m_history.front().frame)];
+}
+
+void Profiler::beginFrame() {
+    if (!m_enabled || m_inFrame) return;
+
+    ++m_frame;
+    m_inFrame = true;
+    m_depth = 0;
+
+    FrameProfile profile;
+    profile.frame = m_frame;
+    profile.startUs = nowUs();
+    m_history.push_back(std::move(profile));
+    while (m_history.size() > m_historySize) m_history.pop_front();
+
+    // This slot was last used GpuLatency frames ago, its queries are done by now
+    GpuFrame& slot = m_gpuFrames[m_frame % GpuLatency];
+    if (slot.pending) resolve(slot);
+    slot.frame = m_frame;
+    slot.passes.clear();
+    slot.pending = true;
+}
+
+void Profiler::endFrame() {
+    if (!m_inFrame) return;
+
+    switchGpuPass(GpuPass::Count);
+    FrameProfile& profile = m_history.back();
+    profile.cpuMs = (nowUs() - profile.startUs) / 1000.0;
+    m_inFrame = false;
+}
+
+GpuPass Profiler::switchGpuPass(GpuPass pass) {
+    if (!m_inFrame) return GpuPass::Count;
+
+    GpuPass previous = m_activePass;
+    if (pass == previous) return previous;
+
+    if (previous != GpuPass::Count) {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+    if (pass != GpuPass::Count) {
+        GpuFrame& slot = m_gpuFrames[m_frame % GpuLatency];
+        size_t index = slot.passes.size();
+        if (index == slot.queries.size()) {
+            GLuint query = 0;
+            glGenQueries(1, &query);
+            slot.queries.push_back(query);
+        }
+        glBeginQuery(GL_TIME_ELAPSED, slot.queries[index]);
+        slot.passes.push_back(pass);
+    }
+    m_activePass = pass;
+    return previous;
+}
+
+void Profiler::resolve(GpuFrame& slot) {
+    FrameProfile* profile = find(slot.frame);
+
+    for (size_t i = 0; i < slot.passes.size(); ++i) {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &nanoseconds);
+        if (!profile) continue;
+
+        double ms = static_cast<double>(nanoseconds) / 1.0e6;
+        profile->gpuEvents.push_back({ slot.passes[i], ms });
+        profile->gpuMs[static_cast<size_t>(slot.passes[i])] += ms;
+    }
+    if (profile) profile->gpuResolved = true;
+    slot.pending = false;
+}
+
+void Profiler::setCounters(const FrameCounters& counters) {
+    if (m_inFrame) m_history.back().counters = counters;
+}
+
+const FrameProfile* Profiler::latest() const {
+    for (auto it = m_history.rbegin(); it != m_history.rend(); ++it) {
+        if (it->gpuResolved) return &*it;
+    }
+    return nullptr;
+}
+
+const char* Profiler::passName(GpuPass pass) {
+    switch (pass) {
+        case GpuPass::Clear:   return "Clear";
+        case GpuPass::Shadows: return "Shadows";
+        case GpuPass::Lights:  return "Lights";
+        case GpuPass::Shapes:  return "Shapes";
+        case GpuPass::Text:    return "Text";
+        case GpuPass::Count:   break;
+    }
+    return "Unknown";
+}
+
+Profiler::CpuScope::CpuScope(Profiler& profiler, const char* name)
+    : m_profiler(&profiler), m_event(static_cast<size_t>(-1)) {
+    if (!profiler.m_inFrame) return;
+
+    auto& events = profiler.m_history.back().cpuEvents;
+    m_event = events.size();
+    events.push_back({ name, profiler.nowUs(), 0.0, profiler.m_depth++ });
+}
+
+Profiler::CpuScope::~CpuScope() {
+    if (m_event == static_cast<size_t>(-1) || !m_profiler->m_inFrame) return;
+
+    auto& events = m_profiler->m_history.back().cpuEvents;
+    if (m_event >= events.size()) return;
+    events[m_event].durationUs = m_profiler->nowUs() - events[m_event].startUs;
+    m_profiler->m_depth--;
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to open trace file: " << path << std::endl;
+        return false;
+    }
+
+    // Microseconds since the profiler was created: the default 6 significant
+    // digits would round them to whole milliseconds after a few minutes
+    out << std::fixed << std::setprecision(3);
+
+    // pid 1 for everything, tid 1 = CPU, tid 2 = GPU
+    out << "{\"traceEvents\":[\n";
+    out << R"({"name":"thread_name","ph":"M","pid":1,"tid":1,"args":{"name":"CPU"}},)" << "\n";
+    out << R"({"name":"thread_name","ph":"M","pid":1,"tid":2,"args":{"name":"GPU"}})";
+
+    for (const auto& frame : m_history) {
+        out << ",\n{\"name\":\"Frame " << frame.frame << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+            << ",\"ts\":" << frame.startUs << ",\"dur\":" << frame.cpuMs * 1000.0 << "}";
+
+        for (const auto& event : frame.cpuEvents) {
+            out << ",\n{\"name\":\"" << jsonEscape(event.name) << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+                << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs << "}";
+        }
+
+        double gpuTs = frame.startUs;
+        for (const auto& event : frame.gpuEvents) {
+            out << ",\n{\"name\":\"" << passName(event.pass) << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":2"
+                << ",\"ts\":" << gpuTs << ",\"dur\":" << event.durationMs * 1000.0 << "}";
+            gpuTs += event.durationMs * 1000.0;
+        }
+
+        const FrameCounters& c = frame.counters;
+        out << ",\n{\"name\":\"Renderer\",\"ph\":\"C\",\"pid\":1,\"ts\":" << frame.startUs
+            << ",\"args\":{\"drawCalls\":" << c.drawCalls << ",\"stateChanges\":" << c.stateChanges
+            << ",\"vertices\":" << c.vertices << ",\"uploadedBytes\":" << c.uploadedBytes << "}}";
+    }
+
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,104 @@
+#include "../../include/includes.h"
+
+// Interpolates over the shorter arc, so 350 -> 10 turns 20 degrees rather than 340
+static float lerpDegrees(float from, float to, float alpha) {
+    float delta = std::fmod(to - from, 360.0f);
+    if (delta > 180.0f) delta -= 360.0f;
+    else if (delta < -180.0f) delta += 360.0f;
+    // Measured back from the target so alpha 1 lands on it exactly
+    return to - delta * (1.0f - alpha);
+}
+
+void RenderCommandList::setTransform(std::shared_ptr<Shape> shape, const glm::vec2& position, float rotationDegrees,
+                                     const glm::vec2& scale) {
+    Transform transform{ position, rotationDegrees, scale };
+    setTransform(std::move(shape), transform, transform);
+}
+
+void RenderCommandList::setTransform(std::shared_ptr<Shape> shape, const Transform& previous, const Transform& current) {
+    if (!shape) return;
+    push(Type::Transform, m_transforms, ShapeTransform{ std::move(shape), previous, current });
+}
+
+void RenderCommandList::setTint(std::shared_ptr<Shape> shape, const glm::vec4& tint) {
+    if (!shape) return;
+    push(Type::Tint, m_shapeValues, ShapeValue{ std::move(shape), tint });
+}
+
+void RenderCommandList::setVisible(std::shared_ptr<Shape> shape, bool visible) {
+    if (!shape) return;
+    push(Type::Visible, m_shapeValues, ShapeValue{ std::move(shape), glm::vec4(visible ? 1.0f : 0.0f) });
+}
+
+void RenderCommandList::setLight(std::shared_ptr<LightSource> light, const LightSource& state) {
+    if (!light) return;
+    push(Type::Light, m_lights, LightState{ std::move(light), state.position, state.direction, state.color,
+                                            state.intensity, state.cutoff, state.radius });
+}
+
+void RenderCommandList::setCamera(const glm::vec2& position, float zoom) {
+    setCamera(position, zoom, position, zoom);
+}
+
+void RenderCommandList::setCamera(const glm::vec2& previousPosition, float previousZoom, const glm::vec2& position,
+                                  float zoom) {
+    push(Type::Camera, m_cameras, CameraState{ previousPosition, previousZoom, position, zoom });
+}
+
+void RenderCommandList::run(Callback callback) {
+    if (!callback) return;
+    push(Type::Callback, m_callbacks, std::move(callback));
+}
+
+void RenderCommandList::execute(Graphics& graphics, float alpha) {
+    for (const Command& command : m_commands) {
+        switch (command.type) {
+            case Type::Transform: {
+                const ShapeTransform& t = m_transforms[command.index];
+                t.shape->setPosition(glm::mix(t.previous.position, t.current.position, alpha));
+                t.shape->setRotation(lerpDegrees(t.previous.rotation, t.current.rotation, alpha));
+                t.shape->setScale(glm::mix(t.previous.scale, t.current.scale, alpha));
+                break;
+            }
+            case Type::Tint: {
+                const ShapeValue& v = m_shapeValues[command.index];
+                v.shape->tint = v.value;
+                break;
+            }
+            case Type::Visible: {
+                const ShapeValue& v = m_shapeValues[command.index];
+                v.shape->isVisible = v.value.x > 0.5f;
+                break;
+            }
+            case Type::Light: {
+                const LightState& l = m_lights[command.index];
+                l.light->position = l.position;
+                l.light->direction = l.direction;
+                l.light->color = l.color;
+                l.light->intensity = l.intensity;
+                l.light->cutoff = l.cutoff;
+                l.light->radius = l.radius;
+                break;
+            }
+            case Type::Camera: {
+                const CameraState& c = m_cameras[command.index];
+                graphics.getCamera()->setPosition(glm::mix(c.previousPosition, c.position, alpha));
+                graphics.getCamera()->setZoom(c.previousZoom + (c.zoom - c.previousZoom) * alpha);
+                break;
+            }
+            case Type::Callback:
+                m_callbacks[command.index](graphics);
+                break;
+        }
+    }
+}
+
+void RenderCommandList::clear() {
+    // Capacity is kept, steady-state frames record without allocating
+    m_commands.clear();
+    m_transforms.clear();
+    m_shapeValues.clear();
+    m_lights.clear();
+    m_cameras.clear();
+    m_callbacks.clear();
+}
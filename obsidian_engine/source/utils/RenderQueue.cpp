@@ -0,0 +1,93 @@
+#include "../../include/includes.h"
+
+// Maps a float to an unsigned integer with the same ordering
+static uint32_t orderedBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+uint64_t RenderQueue::makeKey(float depth, RenderItem::Kind kind, GLuint program, GLuint texture, GLuint mesh) {
+    uint64_t key = static_cast<uint64_t>(orderedBits(depth)) << 32;
+    key |= static_cast<uint64_t>(kind == RenderItem::Kind::Light ? 0 : 1) << 31;
+    key |= static_cast<uint64_t>(program & 0x7Fu) << 24;
+    key |= static_cast<uint64_t>(texture & 0xFFFu) << 12;
+    key |= static_cast<uint64_t>(mesh & 0xFFFu);
+    return key;
+}
+
+void RenderQueue::add(LightSource* light, float depth) {
+    RenderItem item;
+    item.kind = RenderItem::Kind::Light;
+    item.light = light;
+    item.order = m_nextOrder++;
+    item.key = makeKey(depth, item.kind, 0, 0, 0);
+    m_added.push_back(item);
+}
+
+void RenderQueue::add(InstancedShape* group, float depth) {
+    RenderItem item;
+    item.kind = RenderItem::Kind::Instanced;
+    item.instanced = group;
+    item.order = m_nextOrder++;
+    item.key = makeKey(depth, item.kind, 0, 0, 0);
+    m_added.push_back(item);
+}
+
+void RenderQueue::track(Shape* shape) {
+    shape->m_renderOrder = m_nextOrder++;
+    shape->m_queueFrame = 0;
+}
+
+void RenderQueue::remove(Shape* shape) {
+    m_removed.push_back(shape);
+}
+
+void RenderQueue::remove(const void* object) {
+    auto matches = [object](const RenderItem& item) { return item.object() == object; };
+    m_items.erase(std::remove_if(m_items.begin(), m_items.end(), matches), m_items.end());
+    m_added.erase(std::remove_if(m_added.begin(), m_added.end(), matches), m_added.end());
+}
+
+void RenderQueue::clear() {
+    m_items.clear();
+    m_next.clear();
+    m_added.clear();
+    m_removed.clear();
+}
+
+static bool itemLess(const RenderItem& a, const RenderItem& b) {
+    return a.key != b.key ? a.key < b.key : a.order < b.order;
+}
+
+void RenderQueue::sort() {
+    m_sortMoves = 0;
+
+    size_t descents = 0;
+    for (size_t i = 1; i < m_items.size(); ++i) {
+        if (itemLess(m_items[i], m_items[i - 1])) descents++;
+    }
+    if (descents == 0) return;
+
+    // First frame or a reshuffled scene: insertion sort would go quadratic
+    if (descents * 32 > m_items.size()) {
+        std::sort(m_items.begin(), m_items.end(), itemLess);
+        m_sortMoves = m_items.size();
+        return;
+    }
+
+    // Insertion sort: linear on the nearly sorted lists update() produces.
+    // (key, order) is unique, so the result matches a full sort.
+    for (size_t i = 1; i < m_items.size(); ++i) {
+        RenderItem item = m_items[i];
+        size_t j = i;
+        while (j > 0 && itemLess(item, m_items[j - 1])) {
+            m_items[j] = m_items[j - 1];
+            --j;
+        }
+        if (j != i) {
+            m_items[j] = item;
+            m_sortMoves += i - j;
+        }
+    }
+}
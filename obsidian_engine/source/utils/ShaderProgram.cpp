@@ -0,0 +1,74 @@
+#include "../../include/includes.h"
+
+// Indexed by UniformID
+static const char* uniformNames[] = {
+    "uMVP",
+    "uModel",
+    "uView",
+    "uTexture",
+    "uTint",
+    "uUVRect",
+    "uLightPos",
+    "uLightDir",
+    "uCutoff",
+    "uLightColor",
+    "uIntensity",
+    "uRadius",
+    "uShadowMap",
+    "uShadowRow",
+};
+
+static_assert(sizeof(uniformNames) / sizeof(uniformNames[0]) == static_cast<size_t>(UniformID::Count),
+              "uniformNames must match UniformID");
+
+void ShaderProgram::reflect() {
+    m_locations.fill(-1);
+    m_named.clear();
+
+    GLuint frameBlock = glGetUniformBlockIndex(id, "FrameData");
+    if (frameBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(id, frameBlock, static_cast<GLuint>(UniformBlock::Frame));
+    }
+    GLuint lightsBlock = glGetUniformBlockIndex(id, "Lights");
+    if (lightsBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(id, lightsBlock, static_cast<GLuint>(UniformBlock::Lights));
+    }
+
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<char> buffer(static_cast<size_t>(std::max(maxLength, 1)));
+
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(id, static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()), &length, &size, &type, buffer.data());
+
+        std::string name(buffer.data(), length);
+
+        // Plain arrays are reported once as "name[0]"; register every element
+        std::vector<std::string> names;
+        if (size > 1 && name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+            std::string base = name.substr(0, name.size() - 3);
+            for (GLint element = 0; element < size; ++element) {
+                names.push_back(base + "[" + std::to_string(element) + "]");
+            }
+            m_named[base] = glGetUniformLocation(id, name.c_str());
+        } else {
+            names.push_back(name);
+        }
+
+        for (const auto& elementName : names) {
+            GLint loc = glGetUniformLocation(id, elementName.c_str());
+            if (loc < 0) continue;
+            m_named[elementName] = loc;
+
+            for (size_t u = 0; u < static_cast<size_t>(UniformID::Count); ++u) {
+                if (elementName == uniformNames[u]) m_locations[u] = loc;
+            }
+        }
+    }
+}
@@ -0,0 +1,329 @@
+#include "../../include/includes.h"
+
+static constexpr float pi = glm::pi<float>();
+
+ShadowMap::~ShadowMap() {
+    destroy();
+}
+
+void ShadowMap::destroy() {
+    if (m_texture) {
+        glDeleteTextures(1, &m_texture);
+        m_texture = 0;
+    }
+    if (m_fbo) {
+        glDeleteFramebuffers(1, &m_fbo);
+        m_fbo = 0;
+    }
+    if (m_vao) {
+        glDeleteVertexArrays(1, &m_vao);
+        m_vao = 0;
+    }
+    m_capacity = 0;
+    m_rows.clear();
+    m_freeRows.clear();
+    m_usedRows = 0;
+}
+
+void ShadowMap::setResolution(int texels) {
+    m_resolution = std::max(texels, 16);
+
+    // Reallocated on the next update
+    if (m_texture) {
+        glDeleteTextures(1, &m_texture);
+        m_texture = 0;
+        m_capacity = 0;
+    }
+    for (auto& [light, row] : m_rows) {
+        row.drawn = false;
+    }
+}
+
+bool ShadowMap::casts(const LightSource& light) {
+    return light.castsShadows && light.type == LightType::Point && light.radius > 0.0f;
+}
+
+float ShadowMap::rowCoord(const LightSource& light) const {
+    auto it = m_rows.find(&light);
+    if (it == m_rows.end() || it->second.row < 0 || it->second.row >= m_capacity) return -1.0f;
+    return (static_cast<float>(it->second.row) + 0.5f) / static_cast<float>(m_capacity);
+}
+
+void ShadowMap::allocate(int rows) {
+    if (!m_fbo) {
+        glGenFramebuffers(1, &m_fbo);
+        glGenVertexArrays(1, &m_vao);
+    }
+    if (m_texture) {
+        glDeleteTextures(1, &m_texture);
+    }
+
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, m_resolution, rows, 0,
+                 GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+
+    // Angles wrap around, rows never blend into each other
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_texture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Shadow map framebuffer not complete!" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+
+    m_capacity = rows;
+    for (auto& [light, row] : m_rows) {
+        row.drawn = false;
+    }
+}
+
+uint64_t ShadowMap::signature(const LightSource& light, const std::vector<Shape*>& casters) const {
+    // FNV-1a over everything the row depends on
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const void* data, size_t bytes) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < bytes; ++i) {
+            hash = (hash ^ p[i]) * 1099511628211ull;
+        }
+    };
+
+    mix(&light.position, sizeof(light.position));
+    mix(&light.radius, sizeof(light.radius));
+    for (const Shape* shape : casters) {
+        // Dynamic shapes rewrite their vertices without notice
+        uint32_t revision = shape->dynamic ? m_frame : shape->m_revision;
+        mix(&shape, sizeof(shape));
+        mix(&revision, sizeof(revision));
+    }
+    return hash;
+}
+
+int ShadowMap::update(const std::vector<std::shared_ptr<LightSource>>& lights, size_t count,
+                      SpatialGrid& grid, StreamBuffer& stream, const ShaderProgram& program) {
+    ++m_frame;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!casts(*lights[i])) continue;
+        m_rows[lights[i].get()].frame = m_frame;
+    }
+
+    // Recycle the rows of removed lights and of lights that stopped casting
+    for (auto it = m_rows.begin(); it != m_rows.end();) {
+        if (it->second.frame != m_frame) {
+            if (it->second.row >= 0) m_freeRows.push_back(it->second.row);
+            it = m_rows.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (m_rows.empty()) return 0;
+
+    if (!m_maxRows) {
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &m_maxRows);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        auto it = m_rows.find(lights[i].get());
+        if (it == m_rows.end() || it->second.row >= 0) continue;
+
+        if (!m_freeRows.empty()) {
+            it->second.row = m_freeRows.back();
+            m_freeRows.pop_back();
+        } else if (m_usedRows < m_maxRows) {
+            it->second.row = m_usedRows++;
+        }
+    }
+
+    if (m_usedRows > m_capacity || !m_texture) {
+        int rows = std::max(m_capacity, 8);
+        while (rows < m_usedRows) rows *= 2;
+        allocate(std::min(rows, m_maxRows));
+    }
+
+    m_vertices.clear();
+    m_dirtyRows.clear();
+
+    for (size_t i = 0; i < count; ++i) {
+        const LightSource& light = *lights[i];
+        auto it = m_rows.find(&light);
+        if (it == m_rows.end() || it->second.row < 0) continue;
+        Row& row = it->second;
+
+        m_casters.clear();
+        glm::vec2 extent(light.radius);
+        grid.query(AABB{ light.position - extent, light.position + extent }, m_casters);
+        m_casters.erase(std::remove_if(m_casters.begin(), m_casters.end(),
+                                       [](const Shape* shape) { return !shape->castsShadow || !shape->isVisible; }),
+                        m_casters.end());
+
+        uint64_t hash = signature(light, m_casters);
+        if (row.drawn && row.signature == hash) continue;
+
+        row.signature = hash;
+        row.drawn = true;
+        m_dirtyRows.push_back(row.row);
+        appendCasters(row.row, light, m_casters);
+    }
+
+    if (!m_dirtyRows.empty()) {
+        draw(stream, program);
+    }
+    return static_cast<int>(m_dirtyRows.size());
+}
+
+void ShadowMap::appendCasters(int row, const LightSource& light, const std::vector<Shape*>& casters) {
+    for (const Shape* shape : casters) {
+        const glm::mat4& model = shape->getModelMatrix();
+        m_points.clear();
+        for (const auto& vertex : shape->vertices) {
+            m_points.push_back(glm::vec2(model * glm::vec4(vertex.position, 0.0f, 1.0f)));
+        }
+
+        GLuint n = static_cast<GLuint>(shape->indices.empty() ? m_points.size() : shape->indices.size());
+        auto at = [shape](GLuint k) { return shape->indices.empty() ? k : shape->indices[k]; };
+
+        m_edges.clear();
+        auto addTriangle = [&](GLuint a, GLuint b, GLuint c) {
+            m_edges.emplace_back(std::min(a, b), std::max(a, b));
+            m_edges.emplace_back(std::min(b, c), std::max(b, c));
+            m_edges.emplace_back(std::min(c, a), std::max(c, a));
+        };
+
+        switch (shape->type) {
+            case PrimitiveType::Triangles:
+                for (GLuint k = 0; k + 2 < n; k += 3) addTriangle(at(k), at(k + 1), at(k + 2));
+                break;
+            case PrimitiveType::TriangleStrip:
+                for (GLuint k = 0; k + 2 < n; ++k) addTriangle(at(k), at(k + 1), at(k + 2));
+                break;
+            case PrimitiveType::TriangleFan:
+                // The outline is enough: every ray enters the fan through it
+                for (GLuint k = 0; k + 1 < n; ++k) appendEdge(row, light, m_points[at(k)], m_points[at(k + 1)]);
+                if (n > 2) appendEdge(row, light, m_points[at(n - 1)], m_points[at(0)]);
+                continue;
+            case PrimitiveType::Lines:
+                for (GLuint k = 0; k + 1 < n; k += 2) appendEdge(row, light, m_points[at(k)], m_points[at(k + 1)]);
+                continue;
+            case PrimitiveType::Points:
+                continue;
+        }
+
+        // Edges shared by two triangles are inside the shape and can never be nearest
+        std::sort(m_edges.begin(), m_edges.end());
+        for (size_t k = 0; k < m_edges.size();) {
+            size_t end = k + 1;
+            while (end < m_edges.size() && m_edges[end] == m_edges[k]) ++end;
+            if (end - k == 1) {
+                appendEdge(row, light, m_points[m_edges[k].first], m_points[m_edges[k].second]);
+            }
+            k = end;
+        }
+    }
+}
+
+void ShadowMap::appendEdge(int row, const LightSource& light, const glm::vec2& from, const glm::vec2& to) {
+    glm::vec2 a = (from - light.position) / light.radius;
+    glm::vec2 b = (to - light.position) / light.radius;
+
+    // Skip edges entirely outside the radius
+    glm::vec2 edge = b - a;
+    float lengthSq = glm::dot(edge, edge);
+    float t = lengthSq > 0.0f ? glm::clamp(-glm::dot(a, edge) / lengthSq, 0.0f, 1.0f) : 0.0f;
+    glm::vec2 closest = a + t * edge;
+    if (glm::dot(closest, closest) >= 1.0f) return;
+
+    float angleA = std::atan2(a.y, a.x);
+    float angleB = std::atan2(b.y, b.x);
+    float span = angleB - angleA;
+    if (span > pi) span -= 2.0f * pi;
+    if (span < -pi) span += 2.0f * pi;
+
+    // The light sits on the edge; there is no meaningful direction to shadow
+    if (std::abs(span) >= pi - 1e-4f) return;
+
+    // Pad by a texel on both sides so thin edges still cover a texel center.
+    // The fragment shader clamps to the edge, so the padding never overshoots.
+    float texel = 2.0f * pi / static_cast<float>(m_resolution);
+    float lo = (span >= 0.0f ? angleA : angleB) - texel;
+    float hi = lo + std::abs(span) + 2.0f * texel;
+
+    glm::vec4 segment(a, b);
+    appendQuad(row, lo, hi, segment);
+    if (hi > pi) appendQuad(row, lo - 2.0f * pi, hi - 2.0f * pi, segment);
+    if (lo < -pi) appendQuad(row, lo + 2.0f * pi, hi + 2.0f * pi, segment);
+}
+
+void ShadowMap::appendQuad(int row, float angleMin, float angleMax, const glm::vec4& segment) {
+    float x0 = angleMin / pi;
+    float x1 = angleMax / pi;
+    float y0 = static_cast<float>(row) / static_cast<float>(m_capacity) * 2.0f - 1.0f;
+    float y1 = static_cast<float>(row + 1) / static_cast<float>(m_capacity) * 2.0f - 1.0f;
+
+    m_vertices.push_back({ glm::vec2(x0, y0), segment });
+    m_vertices.push_back({ glm::vec2(x1, y0), segment });
+    m_vertices.push_back({ glm::vec2(x1, y1), segment });
+    m_vertices.push_back({ glm::vec2(x0, y0), segment });
+    m_vertices.push_back({ glm::vec2(x1, y1), segment });
+    m_vertices.push_back({ glm::vec2(x0, y1), segment });
+}
+
+void ShadowMap::draw(StreamBuffer& stream, const ShaderProgram& program) {
+    GLint previousFbo = 0;
+    GLint viewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean depthMask = GL_TRUE;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glViewport(0, 0, m_resolution, m_capacity);
+    glDepthMask(GL_TRUE);
+
+    // Depth 1 = no caster within the radius
+    glEnable(GL_SCISSOR_TEST);
+    glClearDepth(1.0);
+    for (int row : m_dirtyRows) {
+        glScissor(0, row, m_resolution, 1);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+    glDisable(GL_SCISSOR_TEST);
+
+    if (!m_vertices.empty()) {
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glDisable(GL_BLEND);
+
+        size_t offset = stream.write(m_vertices.data(), m_vertices.size() * sizeof(EdgeVertex), sizeof(EdgeVertex));
+
+        glBindVertexArray(m_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, stream.id());
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(EdgeVertex), (void*)offsetof(EdgeVertex, position));
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(EdgeVertex), (void*)offsetof(EdgeVertex, segment));
+
+        glUseProgram(program.id);
+        glUniform1f(program.location("uResolution"), static_cast<float>(m_resolution));
+        glDrawArrays(GL_TRIANGLES, static_cast<GLint>(offset / sizeof(EdgeVertex)), static_cast<GLsizei>(m_vertices.size()));
+        glBindVertexArray(0);
+    }
+
+    if (!depthTest) glDisable(GL_DEPTH_TEST);
+    if (blend) glEnable(GL_BLEND);
+    glDepthMask(depthMask);
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFbo));
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
@@ -4,64 +4,201 @@
 
 #include "../../include/includes.h"
 
-GLuint generateWhiteTexture() {
-    GLuint whiteTexture;
-    unsigned char whitePixel[4] = { 255, 255, 255, 255 };
-    glGenTextures(1, &whiteTexture);
-    glBindTexture(GL_TEXTURE_2D, whiteTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, whitePixel);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    return whiteTexture;
+Shape::Shape(const std::vector<Vertex>& verts, Texture texture, PrimitiveType drawType)
+    : vertices(verts), type(drawType), texture(texture), m_mesh(MeshRegistry::create()) {
+    // No normal calculation in 2D
+    initBuffers();
 }
 
-Shape::Shape(const std::vector<Vertex>& verts, Texture texture, PrimitiveType drawType)
-    : vertices(verts), type(drawType), texture(texture) {
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
+Shape::Shape(const std::vector<Vertex>& verts, const std::vector<GLuint>& idx, Texture texture, PrimitiveType drawType)
+    : vertices(verts), indices(idx), type(drawType), texture(texture), m_mesh(MeshRegistry::create()) {
 
-    // No normal calculation in 2D
-    updateBuffers();
+    initBuffers();
 }
 
-void Shape::updateBuffers() {
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+void Shape::initBuffers() {
+    glBindVertexArray(m_mesh->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_mesh->vbo);
+    uploadVertices();
+    setVertexAttributes(m_format);
+
+    if (!indices.empty()) {
+        if (!m_mesh->ebo) glGenBuffers(1, &m_mesh->ebo);
+        // The element binding is part of the VAO state
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_mesh->ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    }
 
-    // position: vec2
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+    glBindVertexArray(0);
+}
 
-    // color: vec4
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+void Shape::uploadVertices() {
+    GLint size = 0;
+    GLsizeiptr bytes = vertices.size() * vertexStride(m_format);
+    glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+
+    std::vector<PackedVertex> packed;
+    const void* data = vertices.data();
+    if (m_format == VertexFormat::Packed) {
+        packed.assign(vertices.begin(), vertices.end());
+        data = packed.data();
+    }
+
+    // Same size: overwrite in place, the attribute setup in the VAO stays valid
+    if (size == bytes) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, data);
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, bytes, data, GL_STATIC_DRAW);
+    }
+}
+
+void Shape::updateBuffers() {
+    markGeometryChanged();
+    if (dynamic) return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_mesh->vbo);
+    uploadVertices();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (!indices.empty()) {
+        if (!m_mesh->ebo) {
+            // First indices for this shape: attach a new element buffer to the VAO
+            initBuffers();
+            return;
+        }
+        glBindVertexArray(m_mesh->vao);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+    }
+}
 
-    // uv: vec2
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, uv));
+void Shape::setVertexFormat(VertexFormat format) {
+    if (format == m_format) return;
 
+    m_format = format;
+    glBindVertexArray(m_mesh->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_mesh->vbo);
+    uploadVertices();
+    setVertexAttributes(m_format);
     glBindVertexArray(0);
 }
 
-void Shape::draw(const glm::mat4& view, const glm::mat4& projection, GLuint shaderProgram) {
+const glm::mat4& Shape::getModelMatrix() const {
+    if (m_modelDirty) {
+        float radians = glm::radians(m_rotation);
+        float c = cos(radians);
+        float sn = sin(radians);
+
+        // T * R * S written out directly, no intermediate matrices
+        m_modelMatrix = glm::mat4(1.0f);
+        m_modelMatrix[0][0] = c * m_scale.x;
+        m_modelMatrix[0][1] = sn * m_scale.x;
+        m_modelMatrix[1][0] = -sn * m_scale.y;
+        m_modelMatrix[1][1] = c * m_scale.y;
+        m_modelMatrix[3][0] = m_position.x;
+        m_modelMatrix[3][1] = m_position.y;
+        m_modelDirty = false;
+    }
+    return m_modelMatrix;
+}
+
+void Shape::markTransformed() {
+    m_modelDirty = true;
+    m_worldBoundsDirty = true;
+    ++m_revision;
+    notifyGrid();
+}
+
+void Shape::markGeometryChanged() {
+    m_localBoundsDirty = true;
+    m_worldBoundsDirty = true;
+    ++m_revision;
+    notifyGrid();
+}
+
+void Shape::notifyGrid() {
+    if (m_grid && !m_gridMoved) {
+        m_gridMoved = true;
+        m_grid->markMoved(this);
+    }
+}
+
+const AABB& Shape::getLocalBounds() const {
+    if (m_localBoundsDirty) {
+        if (vertices.empty()) {
+            m_localBounds = AABB();
+        } else {
+            m_localBounds.min = m_localBounds.max = vertices[0].position;
+            for (const auto& v : vertices) {
+                m_localBounds.min = glm::min(m_localBounds.min, v.position);
+                m_localBounds.max = glm::max(m_localBounds.max, v.position);
+            }
+        }
+        m_localBoundsDirty = false;
+    }
+    return m_localBounds;
+}
+
+const AABB& Shape::getWorldBounds() const {
+    if (m_worldBoundsDirty) {
+        m_worldBounds = AABB::transformed(getLocalBounds(), getModelMatrix());
+        m_worldBoundsDirty = false;
+    }
+    return m_worldBounds;
+}
+
+void Shape::setPosition(const glm::vec2& position) {
+    m_position = position;
+    markTransformed();
+}
+
+void Shape::setRotation(float degrees) {
+    m_rotation = degrees;
+    markTransformed();
+}
+
+void Shape::setScale(const glm::vec2& scale) {
+    m_scale = scale;
+    markTransformed();
+}
+
+void Shape::draw(const glm::mat4& view, const glm::mat4& projection, const ShaderProgram& shaderProgram) {
     if (!isVisible) return;
 
-    glm::mat4 model = modelMatrix;
-    glm::mat4 mvp = projection * view * model;
+    applyUniforms(view, projection, shaderProgram);
+
+    glBindVertexArray(m_mesh->vao);
 
-    glUseProgram(shaderProgram);
+    if (!indices.empty()) {
+        glDrawElements(drawMode(), (GLsizei)indices.size(), GL_UNSIGNED_INT, nullptr);
+    } else {
+        glDrawArrays(drawMode(), 0, (GLsizei)vertices.size());
+    }
 
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "uMVP"), 1, GL_FALSE, &mvp[0][0]);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "uModel"), 1, GL_FALSE, &model[0][0]);
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "uView"), 1, GL_FALSE, &view[0][0]);
+    glBindVertexArray(0);
+}
+
+void Shape::applyUniforms(const glm::mat4& view, const glm::mat4& projection, const ShaderProgram& shaderProgram) const {
+    const glm::mat4& model = getModelMatrix();
+    glUniformMatrix4fv(shaderProgram.location(UniformID::Model), 1, GL_FALSE, &model[0][0]);
+
+    // Engine shaders read view/projection from the FrameData block; only custom
+    // shaders that still declare the plain uniforms need them per draw
+    GLint mvpLoc = shaderProgram.location(UniformID::MVP);
+    if (mvpLoc >= 0) {
+        // The vertex shader applies uModel itself, so uMVP must not contain it again
+        glm::mat4 mvp = projection * view;
+        glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, &mvp[0][0]);
+    }
+    glUniformMatrix4fv(shaderProgram.location(UniformID::View), 1, GL_FALSE, &view[0][0]);
+    glUniform4fv(shaderProgram.location(UniformID::Tint), 1, &tint[0]);
+    glUniform4fv(shaderProgram.location(UniformID::UVRect), 1, &uvRect[0]);
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, texture.getData());
-    glUniform1i(glGetUniformLocation(shaderProgram, "uTexture"), 0);
-
-    glBindVertexArray(vao);
+}
 
+GLenum Shape::drawMode() const {
     GLenum mode = GL_TRIANGLES;
     switch (type) {
         case PrimitiveType::Triangles:    mode = GL_TRIANGLES;    break;
@@ -70,10 +207,19 @@ void Shape::draw(const glm::mat4& view, const glm::mat4& projection, GLuint shad
         case PrimitiveType::Lines:        mode = GL_LINES;        break;
         case PrimitiveType::Points:       mode = GL_POINTS;       break;
     }
+    return mode;
+}
 
-    glDrawArrays(mode, 0, (GLsizei)vertices.size());
-
-    glBindVertexArray(0);
+std::shared_ptr<Shape> Shape::share() const {
+    // The copy shares the mesh resource, so both shapes draw from the same buffers
+    auto copy = std::make_shared<Shape>(*this);
+    copy->queryID = 0;
+    // The copy is not part of any spatial index until it is added itself
+    copy->m_grid = nullptr;
+    copy->m_gridMoved = false;
+    copy->m_queueFrame = 0;
+    copy->m_handle = SlotHandle();
+    return copy;
 }
 
 void Shape::initQuery() {
@@ -88,14 +234,14 @@ void Shape::deleteQuery() {
     }
 }
 
-void Shape::drawOcclusionQuery(const glm::mat4& view, const glm::mat4& projection, GLuint shaderProgram) {
-    glUseProgram(shaderProgram);
+void Shape::drawOcclusionQuery(const glm::mat4& view, const glm::mat4& projection, const ShaderProgram& shaderProgram) {
+    glUseProgram(shaderProgram.id);
 
-    glm::mat4 mvp = projection * view * modelMatrix;
-    GLint loc = glGetUniformLocation(shaderProgram, "uMVP");
-    glUniformMatrix4fv(loc, 1, GL_FALSE, &mvp[0][0]);
+    glm::mat4 mvp = projection * view;
+    glUniformMatrix4fv(shaderProgram.location(UniformID::Model), 1, GL_FALSE, &getModelMatrix()[0][0]);
+    glUniformMatrix4fv(shaderProgram.location(UniformID::MVP), 1, GL_FALSE, &mvp[0][0]);
 
-    glBindVertexArray(vao);
+    glBindVertexArray(m_mesh->vao);
 
     // Using line loop for outlines
     GLenum mode = GL_LINE_LOOP;
@@ -114,11 +260,18 @@ void Shape::drawOcclusionQuery(const glm::mat4& view, const glm::mat4& projectio
     glBindVertexArray(0);
 }
 
+void Shape::setTexture(const Texture& newTexture, const glm::vec4& newUVRect) {
+    texture = newTexture;
+    uvRect = newUVRect;
+}
+
+void Shape::setTexture(const AtlasRegion& region) {
+    setTexture(region.texture, region.uvRect);
+}
+
 void Shape::translate(const glm::vec2& offset) {
-    for (auto& v : vertices) {
-        v.position += offset;
-    }
-    updateBuffers();
+    m_position += offset;
+    markTransformed();
 }
 
 void Shape::rotate(float degrees, const glm::vec2& origin) {
@@ -126,24 +279,20 @@ void Shape::rotate(float degrees, const glm::vec2& origin) {
     float cosAngle = cos(radians);
     float sinAngle = sin(radians);
 
-    for (auto& v : vertices) {
-        glm::vec2 pos = v.position - origin;
-
-        float xnew = pos.x * cosAngle - pos.y * sinAngle;
-        float ynew = pos.x * sinAngle + pos.y * cosAngle;
+    // Rotating about an arbitrary origin moves the shape's position around it
+    glm::vec2 pos = m_position - origin;
+    float xnew = pos.x * cosAngle - pos.y * sinAngle;
+    float ynew = pos.x * sinAngle + pos.y * cosAngle;
 
-        v.position = glm::vec2(xnew, ynew) + origin;
-    }
-    updateBuffers();
+    m_position = glm::vec2(xnew, ynew) + origin;
+    m_rotation += degrees;
+    markTransformed();
 }
 
 void Shape::scale(const glm::vec2& factors, const glm::vec2& origin) {
-    for (auto& v : vertices) {
-        glm::vec2 pos = v.position - origin;
-        pos *= factors;
-        v.position = pos + origin;
-    }
-    updateBuffers();
+    m_position = (m_position - origin) * factors + origin;
+    m_scale *= factors;
+    markTransformed();
 }
 
 // 2D shapes factory functions
@@ -155,7 +304,8 @@ std::shared_ptr<Shape> Shape::createRectangle(float width, float height) {
         Vertex(glm::vec2( width/2,  height/2), glm::vec4(1,1,1,1), glm::vec2(1,1)),
         Vertex(glm::vec2(-width/2,  height/2), glm::vec4(1,1,1,1), glm::vec2(0,1)),
     };
-    return std::make_shared<Shape>(verts, Texture(generateWhiteTexture()), PrimitiveType::TriangleFan);
+    std::vector<GLuint> idx = { 0, 1, 2, 0, 2, 3 };
+    return std::make_shared<Shape>(verts, idx, Texture::white(), PrimitiveType::Triangles);
 }
 
 std::shared_ptr<Shape> Shape::createTriangle(const glm::vec2& p1, const glm::vec2& p2, const glm::vec2& p3) {
@@ -164,22 +314,29 @@ std::shared_ptr<Shape> Shape::createTriangle(const glm::vec2& p1, const glm::vec
         Vertex(p2, glm::vec4(1,1,1,1), glm::vec2(0.5f,1)),
         Vertex(p3, glm::vec4(1,1,1,1), glm::vec2(1,0))
     };
-    return std::make_shared<Shape>(verts, Texture(generateWhiteTexture()), PrimitiveType::Triangles);
+    return std::make_shared<Shape>(verts, Texture::white(), PrimitiveType::Triangles);
 }
 
 std::shared_ptr<Shape> Shape::createCircle(float radius, int segments) {
     std::vector<Vertex> verts;
-    verts.reserve(segments + 2);
+    std::vector<GLuint> idx;
+    verts.reserve(segments + 1);
+    idx.reserve(segments * 3);
 
     verts.push_back(Vertex(glm::vec2(0, 0), glm::vec4(1,1,1,1), glm::vec2(0.5f, 0.5f)));
 
-    for (int i = 0; i <= segments; ++i) {
+    for (int i = 0; i < segments; ++i) {
         float angle = 2.0f * glm::pi<float>() * i / segments;
         float x = radius * cos(angle);
         float y = radius * sin(angle);
         verts.push_back(Vertex(glm::vec2(x, y), glm::vec4(1,1,1,1), glm::vec2(0.5f + 0.5f * cos(angle), 0.5f + 0.5f * sin(angle))));
+
+        // Center, this rim vertex and the next one (wrapping around)
+        idx.push_back(0);
+        idx.push_back(i + 1);
+        idx.push_back(i + 1 < segments ? i + 2 : 1);
     }
 
-    return std::make_shared<Shape>(verts, Texture(generateWhiteTexture()), PrimitiveType::TriangleFan);
+    return std::make_shared<Shape>(verts, idx, Texture::white(), PrimitiveType::Triangles);
 }
 
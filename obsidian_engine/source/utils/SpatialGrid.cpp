@@ -0,0 +1,226 @@
+#include "../../include/includes.h"
+
+SpatialGrid::SpatialGrid(float cellSize)
+    : m_cellSize(std::max(cellSize, 1.0f)) {
+}
+
+SpatialGrid::~SpatialGrid() {
+    clear();
+}
+
+uint64_t SpatialGrid::cellKey(int x, int y) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+uint32_t& SpatialGrid::cellSlot(Entry& entry, int x, int y) {
+    int width = entry.cellMax.x - entry.cellMin.x + 1;
+    return entry.cellPos[(y - entry.cellMin.y) * width + (x - entry.cellMin.x)];
+}
+
+glm::ivec2 SpatialGrid::cellOf(const glm::vec2& point) const {
+    return glm::ivec2(static_cast<int>(std::floor(point.x / m_cellSize)),
+                      static_cast<int>(std::floor(point.y / m_cellSize)));
+}
+
+void SpatialGrid::setCellSize(float cellSize) {
+    m_cellSize = std::max(cellSize, 1.0f);
+
+    m_cells.clear();
+    m_always.clear();
+    m_moved.clear();
+    for (uint32_t i = 0; i < m_entries.size(); ++i) {
+        m_entries[i].cellMax = glm::ivec2(-1);
+        m_entries[i].cellMin = glm::ivec2(0);
+        m_entries[i].always = false;
+        bucket(i);
+    }
+}
+
+void SpatialGrid::insert(Shape* shape) {
+    if (!shape || shape->m_grid == this) return;
+
+    Entry entry;
+    entry.shape = shape;
+    entry.order = m_nextOrder++;
+
+    uint32_t index = static_cast<uint32_t>(m_entries.size());
+    m_entries.push_back(entry);
+
+    shape->m_grid = this;
+    shape->m_gridEntry = index;
+    shape->m_gridMoved = false;
+    bucket(index);
+}
+
+void SpatialGrid::remove(Shape* shape) {
+    if (!shape || shape->m_grid != this) return;
+
+    uint32_t index = shape->m_gridEntry;
+    uint32_t last = static_cast<uint32_t>(m_entries.size() - 1);
+    unbucket(index);
+
+    if (index != last) {
+        // Move the last entry into the hole; its cell lists refer to it by index
+        Shape* moved = m_entries[last].shape;
+        unbucket(last);
+        m_entries[index] = std::move(m_entries[last]);
+        moved->m_gridEntry = index;
+        bucket(index);
+
+        // A pending move recorded under the old index is skipped in update()
+        if (moved->m_gridMoved) m_moved.push_back(index);
+    }
+    m_entries.pop_back();
+
+    shape->m_grid = nullptr;
+    shape->m_gridMoved = false;
+}
+
+void SpatialGrid::clear() {
+    for (auto& entry : m_entries) {
+        entry.shape->m_grid = nullptr;
+        entry.shape->m_gridMoved = false;
+    }
+    m_entries.clear();
+    m_cells.clear();
+    m_always.clear();
+    m_moved.clear();
+}
+
+void SpatialGrid::markMoved(Shape* shape) {
+    m_moved.push_back(shape->m_gridEntry);
+}
+
+void SpatialGrid::bucket(uint32_t index) {
+    Entry& entry = m_entries[index];
+
+    if (entry.shape->dynamic) {
+        entry.always = true;
+        entry.alwaysPos = static_cast<uint32_t>(m_always.size());
+        m_always.push_back(index);
+        return;
+    }
+
+    AABB bounds = entry.shape->getWorldBounds();
+    glm::ivec2 lo = cellOf(bounds.min);
+    glm::ivec2 hi = cellOf(bounds.max);
+
+    int64_t cells = static_cast<int64_t>(hi.x - lo.x + 1) * (hi.y - lo.y + 1);
+    if (cells > maxCellsPerShape) {
+        entry.always = true;
+        entry.alwaysPos = static_cast<uint32_t>(m_always.size());
+        m_always.push_back(index);
+        return;
+    }
+
+    entry.cellMin = lo;
+    entry.cellMax = hi;
+
+    // Remember where it sits in every cell so removal needs no search
+    entry.cellPos.clear();
+    for (int y = lo.y; y <= hi.y; ++y) {
+        for (int x = lo.x; x <= hi.x; ++x) {
+            auto& list = m_cells[cellKey(x, y)];
+            entry.cellPos.push_back(static_cast<uint32_t>(list.size()));
+            list.push_back(index);
+        }
+    }
+}
+
+void SpatialGrid::unbucket(uint32_t index) {
+    Entry& entry = m_entries[index];
+
+    // Swap-remove, then tell the entry moved into the hole where it now sits
+    if (entry.always) {
+        uint32_t pos = entry.alwaysPos;
+        m_always[pos] = m_always.back();
+        m_always.pop_back();
+        if (pos < m_always.size()) m_entries[m_always[pos]].alwaysPos = pos;
+        entry.always = false;
+        return;
+    }
+
+    for (int y = entry.cellMin.y; y <= entry.cellMax.y; ++y) {
+        for (int x = entry.cellMin.x; x <= entry.cellMax.x; ++x) {
+            auto cell = m_cells.find(cellKey(x, y));
+            auto& list = cell->second;
+
+            uint32_t pos = cellSlot(entry, x, y);
+            list[pos] = list.back();
+            list.pop_back();
+            if (pos < list.size()) cellSlot(m_entries[list[pos]], x, y) = pos;
+            if (list.empty()) m_cells.erase(cell);
+        }
+    }
+    entry.cellPos.clear();
+    entry.cellMin = glm::ivec2(0);
+    entry.cellMax = glm::ivec2(-1);
+}
+
+void SpatialGrid::update() {
+    for (uint32_t index : m_moved) {
+        // Stale after a removal: the index is gone or now holds an unmoved shape
+        if (index >= m_entries.size() || !m_entries[index].shape->m_gridMoved) continue;
+
+        Entry& entry = m_entries[index];
+        entry.shape->m_gridMoved = false;
+
+        // Skip re-bucketing when the shape stayed inside the same cells
+        if (!entry.always && !entry.shape->dynamic) {
+            AABB bounds = entry.shape->getWorldBounds();
+            if (cellOf(bounds.min) == entry.cellMin && cellOf(bounds.max) == entry.cellMax) continue;
+        }
+
+        unbucket(index);
+        bucket(index);
+    }
+    m_moved.clear();
+}
+
+void SpatialGrid::query(const AABB& area, std::vector<Shape*>& out) {
+    update();
+
+    // A new stamp per query avoids clearing a visited set
+    if (++m_stamp == 0) {
+        for (auto& entry : m_entries) entry.stamp = 0;
+        m_stamp = 1;
+    }
+
+    size_t first = out.size();
+    auto report = [&](uint32_t index) {
+        Entry& entry = m_entries[index];
+        if (entry.stamp == m_stamp) return;
+        entry.stamp = m_stamp;
+        if (entry.always || entry.shape->getWorldBounds().intersects(area)) {
+            out.push_back(entry.shape);
+        }
+    };
+
+    for (uint32_t index : m_always) {
+        report(index);
+    }
+
+    glm::ivec2 lo = cellOf(area.min);
+    glm::ivec2 hi = cellOf(area.max);
+    int64_t cells = static_cast<int64_t>(hi.x - lo.x + 1) * (hi.y - lo.y + 1);
+
+    if (cells > static_cast<int64_t>(m_cells.size())) {
+        // Zoomed far out: walking the occupied cells is cheaper than the range
+        for (auto& [key, list] : m_cells) {
+            for (uint32_t index : list) report(index);
+        }
+    } else {
+        for (int y = lo.y; y <= hi.y; ++y) {
+            for (int x = lo.x; x <= hi.x; ++x) {
+                auto cell = m_cells.find(cellKey(x, y));
+                if (cell == m_cells.end()) continue;
+                for (uint32_t index : cell->second) report(index);
+            }
+        }
+    }
+
+    // Callers rely on insertion order among equal depths (draw order, instancing runs)
+    std::sort(out.begin() + first, out.end(), [this](Shape* a, Shape* b) {
+        return m_entries[a->m_gridEntry].order < m_entries[b->m_gridEntry].order;
+    });
+}
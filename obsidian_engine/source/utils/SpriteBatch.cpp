@@ -0,0 +1,222 @@
+#include "../../include/includes.h"
+
+static const GLuint quadPattern[6] = { 0, 1, 2, 0, 2, 3 };
+
+SpriteBatch::~SpriteBatch() {
+    destroy();
+}
+
+void SpriteBatch::initialize(StreamBuffer& stream) {
+    if (m_vao != 0) return;
+
+    m_stream = &stream;
+    glGenVertexArrays(1, &m_vao);
+    bindAttributes();
+
+    // 0 1 2 0 2 3, offset by 4 for every following quad
+    std::vector<uint16_t> quadIndices(maxQuads * 6);
+    for (size_t quad = 0; quad < maxQuads; ++quad) {
+        for (size_t k = 0; k < 6; ++k) {
+            quadIndices[quad * 6 + k] = static_cast<uint16_t>(quad * 4 + quadPattern[k]);
+        }
+    }
+    glGenBuffers(1, &m_quadIBO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_quadIBO);
+    glBufferData(GL_ARRAY_BUFFER, quadIndices.size() * sizeof(uint16_t), quadIndices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SpriteBatch::bindAttributes() {
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_stream->id());
+    setVertexAttributes(m_format);
+    glBindVertexArray(0);
+    m_streamGeneration = m_stream->generation();
+}
+
+void SpriteBatch::destroy() {
+    if (m_quadIBO) {
+        glDeleteBuffers(1, &m_quadIBO);
+        m_quadIBO = 0;
+    }
+    if (m_vao) {
+        glDeleteVertexArrays(1, &m_vao);
+        m_vao = 0;
+    }
+    m_stream = nullptr;
+    m_vertices.clear();
+    m_indices.clear();
+}
+
+void SpriteBatch::setFormat(VertexFormat format) {
+    if (format == m_format) return;
+
+    m_format = format;
+    if (m_vao) bindAttributes();
+}
+
+GLint SpriteBatch::streamVertices(const Vertex* vertices, size_t count) {
+    size_t stride = vertexStride(m_format);
+    const void* data = vertices;
+    if (m_format == VertexFormat::Packed) {
+        m_packed.assign(vertices, vertices + count);
+        data = m_packed.data();
+    }
+
+    size_t offset = m_stream->write(data, count * stride, stride);
+
+    // The stream may have been recreated larger, attributes must follow it
+    if (m_streamGeneration != m_stream->generation()) {
+        bindAttributes();
+    }
+    glBindVertexArray(m_vao);
+    return static_cast<GLint>(offset / stride);
+}
+
+size_t SpriteBatch::streamIndices(const GLuint* indices, size_t count) {
+    size_t offset = m_stream->write(indices, count * sizeof(GLuint), sizeof(GLuint));
+    // Expects the batch VAO to be bound, the element binding is part of its state
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_stream->id());
+    return offset;
+}
+
+GLenum SpriteBatch::batchMode(PrimitiveType type) {
+    switch (type) {
+        case PrimitiveType::Lines:  return GL_LINES;
+        case PrimitiveType::Points: return GL_POINTS;
+        case PrimitiveType::Triangles:
+        case PrimitiveType::TriangleFan:
+        case PrimitiveType::TriangleStrip:
+            break;
+    }
+    return GL_TRIANGLES;
+}
+
+bool SpriteBatch::accepts(const ShaderProgram* program, GLuint texture, GLenum mode) const {
+    return m_program == program && m_texture == texture && m_mode == mode;
+}
+
+void SpriteBatch::begin(const ShaderProgram* program, GLuint texture, GLenum mode) {
+    m_vertices.clear();
+    m_indices.clear();
+    m_allQuads = mode == GL_TRIANGLES;
+    m_program = program;
+    m_texture = texture;
+    m_mode = mode;
+}
+
+void SpriteBatch::append(Shape& shape) {
+    const std::vector<Vertex>& src = shape.vertices;
+    const glm::mat4& m = shape.getModelMatrix();
+    const glm::vec4 tint = shape.tint;
+    const glm::vec4 uvRect = shape.uvRect;
+
+    size_t count = src.size();
+
+    // Indices of the shape as a plain list in the batch mode. Fans and strips
+    // are expanded whether their order is implicit or given by shape.indices.
+    const std::vector<GLuint>& order = shape.indices;
+    size_t n = order.empty() ? count : order.size();
+    auto at = [&order](size_t k) { return order.empty() ? static_cast<GLuint>(k) : order[k]; };
+
+    m_localIndices.clear();
+    switch (shape.type) {
+        case PrimitiveType::Triangles:
+            for (size_t i = 0; i + 2 < n; i += 3) {
+                m_localIndices.insert(m_localIndices.end(), { at(i), at(i + 1), at(i + 2) });
+            }
+            break;
+        case PrimitiveType::TriangleFan:
+            for (size_t i = 1; i + 1 < n; ++i) {
+                m_localIndices.insert(m_localIndices.end(), { at(0), at(i), at(i + 1) });
+            }
+            break;
+        case PrimitiveType::TriangleStrip:
+            for (size_t i = 0; i + 2 < n; ++i) {
+                // Keep a consistent winding for odd triangles
+                if (i % 2 == 0) m_localIndices.insert(m_localIndices.end(), { at(i), at(i + 1), at(i + 2) });
+                else            m_localIndices.insert(m_localIndices.end(), { at(i + 1), at(i), at(i + 2) });
+            }
+            break;
+        case PrimitiveType::Lines:
+            for (size_t i = 0; i + 1 < n; i += 2) {
+                m_localIndices.insert(m_localIndices.end(), { at(i), at(i + 1) });
+            }
+            break;
+        case PrimitiveType::Points:
+            break;
+    }
+
+    if (m_allQuads) {
+        m_allQuads = count == 4 && m_localIndices.size() == 6
+            && std::equal(m_localIndices.begin(), m_localIndices.end(), quadPattern);
+    }
+
+    GLuint base = static_cast<GLuint>(m_vertices.size());
+    for (GLuint index : m_localIndices) {
+        m_indices.push_back(base + index);
+    }
+
+    // Only the 2D part of the model matrix matters for z = 0 vertices.
+    // Tint and UV sub-rect are baked in as well, the batch draws with neutral uniforms.
+    for (const Vertex& v : src) {
+        glm::vec2 world(
+            m[0][0] * v.position.x + m[1][0] * v.position.y + m[3][0],
+            m[0][1] * v.position.x + m[1][1] * v.position.y + m[3][1]
+        );
+        glm::vec2 uv(uvRect.x + v.uv.x * uvRect.z, uvRect.y + v.uv.y * uvRect.w);
+        m_vertices.emplace_back(world, v.color * tint, uv);
+    }
+}
+
+int SpriteBatch::flush() {
+    if (m_vertices.empty()) return 0;
+
+    size_t vertexCount = m_vertices.size();
+    size_t quads = vertexCount / 4;
+
+    if (m_mode == GL_POINTS) {
+        GLint first = streamVertices(m_vertices.data(), vertexCount);
+        glDrawArrays(GL_POINTS, first, static_cast<GLsizei>(vertexCount));
+    } else if (m_allQuads && quads <= maxQuads) {
+        GLint first = streamVertices(m_vertices.data(), vertexCount);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_quadIBO);
+        glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(quads * 6), GL_UNSIGNED_SHORT, nullptr, first);
+    } else {
+        // Vertices and indices have to end up in the same buffer generation
+        size_t stride = vertexStride(m_format);
+        m_stream->reserve(vertexCount * stride + m_indices.size() * sizeof(GLuint) + stride);
+
+        GLint first = streamVertices(m_vertices.data(), vertexCount);
+        size_t indexOffset = streamIndices(m_indices.data(), m_indices.size());
+        glDrawElementsBaseVertex(m_mode, static_cast<GLsizei>(m_indices.size()), GL_UNSIGNED_INT,
+                                 (void*)indexOffset, first);
+    }
+
+    glBindVertexArray(0);
+
+    m_vertices.clear();
+    m_indices.clear();
+    m_allQuads = m_mode == GL_TRIANGLES;
+    return static_cast<int>(vertexCount);
+}
+
+void SpriteBatch::drawShape(const Shape& shape) {
+    const std::vector<Vertex>& src = shape.vertices;
+    if (src.empty()) return;
+
+    if (shape.indices.empty()) {
+        GLint first = streamVertices(src.data(), src.size());
+        glDrawArrays(shape.drawMode(), first, static_cast<GLsizei>(src.size()));
+    } else {
+        size_t stride = vertexStride(m_format);
+        m_stream->reserve(src.size() * stride + shape.indices.size() * sizeof(GLuint) + stride);
+
+        GLint first = streamVertices(src.data(), src.size());
+        size_t indexOffset = streamIndices(shape.indices.data(), shape.indices.size());
+        glDrawElementsBaseVertex(shape.drawMode(), static_cast<GLsizei>(shape.indices.size()), GL_UNSIGNED_INT,
+                                 (void*)indexOffset, first);
+    }
+
+    glBindVertexArray(0);
+}
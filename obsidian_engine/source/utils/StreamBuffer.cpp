@@ -0,0 +1,130 @@
+#include "../../include/includes.h"
+
+StreamBuffer::~StreamBuffer() {
+    destroy();
+}
+
+void StreamBuffer::initialize(GLenum target, size_t regionBytes) {
+    if (m_buffer) return;
+
+    m_target = target;
+    allocate(regionBytes);
+}
+
+void StreamBuffer::destroy() {
+    release();
+    m_regionBytes = 0;
+    m_stats = StreamStats();
+}
+
+void StreamBuffer::release() {
+    for (auto& fence : m_fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (m_buffer) {
+        if (m_mapped) {
+            glBindBuffer(m_target, m_buffer);
+            glUnmapBuffer(m_target);
+            glBindBuffer(m_target, 0);
+            m_mapped = nullptr;
+        }
+        // The driver keeps the storage alive for draws that still reference it
+        glDeleteBuffers(1, &m_buffer);
+        m_buffer = 0;
+    }
+}
+
+void StreamBuffer::allocate(size_t regionBytes) {
+    release();
+
+    m_regionBytes = regionBytes;
+    size_t total = m_regionBytes * Regions;
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(m_target, m_buffer);
+
+    if (GLAD_GL_VERSION_4_4) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(m_target, total, nullptr, flags);
+        m_mapped = static_cast<unsigned char*>(glMapBufferRange(m_target, 0, total, flags));
+    } else {
+        glBufferData(m_target, total, nullptr, GL_STREAM_DRAW);
+    }
+
+    m_region = 0;
+    m_head = 0;
+    m_generation++;
+}
+
+void StreamBuffer::beginFrame() {
+    m_stats = StreamStats();
+    if (!m_buffer) return;
+
+    m_region = (m_region + 1) % Regions;
+    m_head = 0;
+
+    GLsync& fence = m_fences[m_region];
+    if (!fence) return;
+
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        // The GPU is more than Regions - 1 frames behind
+        m_stats.stalls++;
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);  // 1 ms
+        } while (status == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void StreamBuffer::endFrame() {
+    if (!m_buffer || m_head == 0) return;
+
+    GLsync& fence = m_fences[m_region];
+    if (fence) glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::reserve(size_t bytes) {
+    if (m_head + bytes <= m_regionBytes) return;
+
+    allocate(std::max(m_regionBytes * 2, bytes));
+    m_stats.resizes++;
+}
+
+size_t StreamBuffer::write(const void* data, size_t bytes, size_t alignment) {
+    size_t base = m_regionBytes * m_region;
+    size_t offset = (base + m_head + alignment - 1) / alignment * alignment;
+
+    if (offset + bytes > base + m_regionBytes) {
+        // Too much data for one frame: start over in a larger buffer
+        allocate(std::max(m_regionBytes * 2, bytes + alignment));
+        m_stats.resizes++;
+        base = 0;
+        offset = 0;
+    }
+
+    glBindBuffer(m_target, m_buffer);
+
+    if (m_mapped) {
+        std::memcpy(m_mapped + offset, data, bytes);
+    } else {
+        // Fences keep the GPU away from this region, so skipping the sync is safe
+        void* dst = glMapBufferRange(m_target, offset, bytes,
+                                     GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if (dst) {
+            std::memcpy(dst, data, bytes);
+            glUnmapBuffer(m_target);
+        } else {
+            glBufferSubData(m_target, offset, bytes, data);
+        }
+    }
+
+    m_head = offset + bytes - base;
+    m_stats.bytes += bytes;
+    return offset;
+}
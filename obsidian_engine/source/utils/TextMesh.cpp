@@ -0,0 +1,172 @@
+#include "../../include/includes.h"
+
+std::shared_ptr<TextMesh> TextMesh::create(Font& font, const std::string& text, const glm::vec2& position,
+                                           float scale, glm::vec3 color, float rotationDegrees) {
+    auto mesh = std::make_shared<TextMesh>(font, text);
+    mesh->setPosition(position);
+    mesh->setRotation(rotationDegrees);
+    mesh->setScale(glm::vec2(scale));
+    mesh->tint = glm::vec4(color, 1.0f);
+    return mesh;
+}
+
+TextMesh::TextMesh(Font& font, const std::string& text)
+    : Shape(std::vector<Vertex>(), std::vector<GLuint>(), Texture(0), PrimitiveType::Triangles),
+      m_font(&font), m_text(text) {
+    m_isText = true;
+    rebuild();
+}
+
+void TextMesh::setText(const std::string& text) {
+    if (text == m_text) return;
+    m_text = text;
+    rebuild();
+}
+
+void TextMesh::setFont(Font& font) {
+    if (&font == m_font && font.revision() == m_fontRevision) return;
+    m_font = &font;
+    rebuild();
+}
+
+void TextMesh::setWrapWidth(float width) {
+    width = std::max(width, 0.0f);
+    if (width == m_wrapWidth) return;
+    m_wrapWidth = width;
+    rebuild();
+}
+
+size_t TextMesh::refresh() {
+    if (m_font->revision() != m_fontRevision) return rebuild();
+    if (vertices.empty()) return 0;
+
+    // Glyphs queued by other text since the last upload may have grown the atlas.
+    // Rows are only appended, so shrinking v keeps every rect in place.
+    size_t bytes = m_font->upload();
+    int height = m_font->atlasSize().y;
+    if (height > 0) uvRect = glm::vec4(0.0f, 0.0f, 1.0f, static_cast<float>(m_atlasHeight) / height);
+    return bytes;
+}
+
+size_t TextMesh::rebuild() {
+    vertices.clear();
+    indices.clear();
+    m_size = glm::vec2(0.0f);
+    m_fontRevision = m_font->revision();
+    shaderName = m_font->mode() == FontMode::SDF ? "textMeshSdf" : "textMesh";
+
+    m_codepoints.clear();
+    if (m_font->loaded()) {
+        for (size_t i = 0; i < m_text.size();) {
+            m_codepoints.push_back(Font::decodeUtf8(m_text, i));
+        }
+    }
+
+    // UVs hold atlas pixels until every glyph is rasterized and the atlas size is final
+    float lineHeight = m_font->lineHeight();
+    float baseline = 0.0f;
+    int lines = 0;
+    auto emitLine = [&](size_t begin, size_t end) {
+        glm::vec2 pen(0.0f, baseline);
+        const Glyph* previous = nullptr;
+        for (size_t i = begin; i < end; ++i) {
+            const Glyph& glyph = m_font->glyph(m_codepoints[i]);
+            if (previous) pen.x += m_font->kerning(*previous, glyph);
+
+            if (glyph.width > 0) {
+                glm::vec2 p0 = pen + glyph.offset;
+                glm::vec2 p1 = p0 + glm::vec2(glyph.width, glyph.height);
+                // Atlas rows run top-down
+                glm::vec2 uv0(glyph.x, glyph.y + glyph.height);
+                glm::vec2 uv1(glyph.x + glyph.width, glyph.y);
+
+                GLuint base = static_cast<GLuint>(vertices.size());
+                vertices.emplace_back(p0, glm::vec4(1.0f), uv0);
+                vertices.emplace_back(glm::vec2(p1.x, p0.y), glm::vec4(1.0f), glm::vec2(uv1.x, uv0.y));
+                vertices.emplace_back(p1, glm::vec4(1.0f), uv1);
+                vertices.emplace_back(glm::vec2(p0.x, p1.y), glm::vec4(1.0f), glm::vec2(uv0.x, uv1.y));
+                indices.insert(indices.end(), { base, base + 1, base + 2, base + 2, base + 3, base });
+            }
+
+            pen.x += glyph.advance;
+            previous = &glyph;
+        }
+        m_size.x = std::max(m_size.x, pen.x);
+        baseline -= lineHeight;
+        lines++;
+    };
+
+    // One pass: the pen width of the current line and of the word after its
+    // last space are kept as they grow, so a break never re-measures the line
+    size_t begin = 0;
+    size_t space = 0;         // Last space in the line, or begin if there is none
+    float width = 0.0f;       // [begin, i)
+    float wordWidth = 0.0f;   // [space + 1, i), measured as if it started a line
+    const Glyph* previous = nullptr;
+    const Glyph* wordPrevious = nullptr;
+    auto startLine = [&](size_t first) {
+        begin = space = first;
+        width = wordWidth = 0.0f;
+        previous = wordPrevious = nullptr;
+    };
+
+    for (size_t i = 0; i < m_codepoints.size(); ++i) {
+        uint32_t codepoint = m_codepoints[i];
+        if (codepoint == '\n') {
+            emitLine(begin, i);
+            startLine(i + 1);
+            continue;
+        }
+
+        const Glyph& glyph = m_font->glyph(codepoint);
+        float kerning = previous ? m_font->kerning(*previous, glyph) : 0.0f;
+
+        if (m_wrapWidth > 0.0f && i != begin && width + kerning + glyph.advance > m_wrapWidth) {
+            // Codepoint i overflows: break at it if it is a space, else at the last
+            // space, or inside a word that fills the whole line
+            if (codepoint == ' ') {
+                emitLine(begin, i);
+                startLine(i + 1);
+                continue;
+            }
+            if (space > begin) {
+                emitLine(begin, space);
+                begin = space + 1;
+                space = begin;
+                width = wordWidth;
+                previous = wordPrevious;
+            } else {
+                emitLine(begin, i);
+                startLine(i);
+            }
+            kerning = previous ? m_font->kerning(*previous, glyph) : 0.0f;
+        }
+
+        width += kerning + glyph.advance;
+        previous = &glyph;
+        if (codepoint == ' ') {
+            space = i;
+            wordWidth = 0.0f;
+            wordPrevious = nullptr;
+        } else {
+            wordWidth += (wordPrevious ? m_font->kerning(*wordPrevious, glyph) : 0.0f) + glyph.advance;
+            wordPrevious = &glyph;
+        }
+    }
+    if (m_font->loaded()) {
+        emitLine(begin, m_codepoints.size());
+        m_size.y = m_font->ascent() - m_font->descent() + (lines - 1) * lineHeight;
+    }
+
+    // The texture has to hold the new glyphs before the shape pass samples it
+    size_t bytes = m_font->upload();
+    glm::ivec2 atlas = m_font->atlasSize();
+    for (Vertex& v : vertices) {
+        v.uv /= glm::vec2(atlas);
+    }
+    m_atlasHeight = atlas.y;
+    setTexture(Texture(m_font->texture()));
+
+    updateBuffers();
+    return bytes;
+}
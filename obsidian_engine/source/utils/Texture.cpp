@@ -1,39 +1,43 @@
-
 #include "../../include/includes.h"
 
 Texture::Texture(const std::string &path, GLint filtering) {
-    int w, h, c;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load(path.c_str(), &w, &h, &c, STBI_rgb_alpha); // force 4 channels
-    if (!data) {
-        std::cerr << "Failed to load texture: " << path << std::endl;
-        return;
-    }
-
+    TextureRegistry* registry = TextureRegistry::active();
+    *this = registry ? registry->load(path, filtering) : TextureRegistry::loadUnregistered(path, filtering);
+}
 
-    GLuint tex;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data); // always use RGBA
+Texture::Texture(GLuint tex) {
+    texture = tex;
+}
 
+Texture::Texture(std::shared_ptr<TextureResource> resource)
+    : m_resource(std::move(resource)) {
+}
 
-    glGenerateMipmap(GL_TEXTURE_2D);
+Texture Texture::white() {
+    TextureRegistry* registry = TextureRegistry::active();
+    return registry ? registry->white() : Texture(0);
+}
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filtering);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filtering);
+Texture Texture::fromPixels(int width, int height, const unsigned char* rgba, GLint filtering) {
+    TextureRegistry* registry = TextureRegistry::active();
+    if (registry) return registry->fromPixels(width, height, rgba, filtering);
 
-    stbi_image_free(data);
-    texture = tex;
+    auto resource = std::make_shared<TextureResource>();
+    resource->id = TextureRegistry::upload(width, height, rgba, filtering, false);
+    return Texture(resource);
 }
 
-Texture::Texture(GLuint tex) {
-    texture = tex;
-}
+Texture Texture::create(int width, int height, GLint filtering) {
+    TextureRegistry* registry = TextureRegistry::active();
+    if (registry) return registry->create(width, height, filtering);
 
+    auto resource = std::make_shared<TextureResource>();
+    resource->id = TextureRegistry::upload(width, height, nullptr, filtering, false);
+    return Texture(resource);
+}
 
-GLuint Texture::getData() {
-    return texture;
+GLuint Texture::getData() const {
+    return m_resource ? m_resource->id : texture;
 }
 
+
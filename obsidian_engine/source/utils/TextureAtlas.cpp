@@ -0,0 +1,165 @@
+#include "../../include/includes.h"
+
+TextureAtlas::TextureAtlas(int pageSize, int padding, bool extrude, GLint filtering)
+    : m_pageSize(pageSize), m_padding(padding), m_extrude(extrude), m_filtering(filtering) {
+}
+
+AtlasRegion TextureAtlas::add(const std::string& path) {
+    auto it = m_regions.find(path);
+    if (it != m_regions.end()) return it->second;
+
+    int w, h, c;
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char* data = stbi_load(path.c_str(), &w, &h, &c, STBI_rgb_alpha); // force 4 channels
+    if (!data) {
+        std::cerr << "Failed to load texture: " << path << std::endl;
+        return AtlasRegion();
+    }
+
+    AtlasRegion region = add(path, w, h, data);
+    stbi_image_free(data);
+    return region;
+}
+
+AtlasRegion TextureAtlas::add(const std::string& name, int width, int height, const unsigned char* rgba) {
+    auto it = m_regions.find(name);
+    if (it != m_regions.end()) return it->second;
+
+    int paddedW = width + m_padding * 2;
+    int paddedH = height + m_padding * 2;
+    if (paddedW > m_pageSize || paddedH > m_pageSize) {
+        std::cerr << "Image too large for atlas page: " << name << std::endl;
+        return AtlasRegion();
+    }
+
+    // Try the existing pages in order before opening a new one
+    Page* target = nullptr;
+    int x = 0, y = 0;
+    for (auto& page : m_pages) {
+        if (place(page, paddedW, paddedH, x, y)) {
+            target = &page;
+            break;
+        }
+    }
+    if (!target) {
+        target = &addPage();
+        place(*target, paddedW, paddedH, x, y);
+    }
+
+    // Build the padded block once, extruding the edge pixels into the border
+    std::vector<unsigned char> block(static_cast<size_t>(paddedW) * paddedH * 4, 0);
+    for (int by = 0; by < paddedH; ++by) {
+        int sy = by - m_padding;
+        if (!m_extrude && (sy < 0 || sy >= height)) continue;
+        sy = std::clamp(sy, 0, height - 1);
+
+        for (int bx = 0; bx < paddedW; ++bx) {
+            int sx = bx - m_padding;
+            if (!m_extrude && (sx < 0 || sx >= width)) continue;
+            sx = std::clamp(sx, 0, width - 1);
+
+            const unsigned char* src = rgba + (static_cast<size_t>(sy) * width + sx) * 4;
+            unsigned char* dst = block.data() + (static_cast<size_t>(by) * paddedW + bx) * 4;
+            std::copy(src, src + 4, dst);
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, target->texture.getData());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, paddedW, paddedH, GL_RGBA, GL_UNSIGNED_BYTE, block.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    float page = static_cast<float>(m_pageSize);
+    AtlasRegion region;
+    region.texture = target->texture;
+    region.uvRect = glm::vec4((x + m_padding) / page, (y + m_padding) / page, width / page, height / page);
+    region.width = width;
+    region.height = height;
+
+    m_regions[name] = region;
+    return region;
+}
+
+AtlasRegion TextureAtlas::find(const std::string& name) const {
+    auto it = m_regions.find(name);
+    return it != m_regions.end() ? it->second : AtlasRegion();
+}
+
+TextureAtlas::Page& TextureAtlas::addPage() {
+    Page page;
+    page.texture = Texture::create(m_pageSize, m_pageSize, m_filtering);
+    page.skyline.push_back({ 0, 0, m_pageSize });
+    m_pages.push_back(std::move(page));
+    return m_pages.back();
+}
+
+// Lowest y at which a width x height rect can sit when its left edge is at node `index`,
+// or -1 if it does not fit
+int TextureAtlas::fit(const Page& page, size_t index, int width, int height) const {
+    int x = page.skyline[index].x;
+    if (x + width > m_pageSize) return -1;
+
+    int y = 0;
+    int remaining = width;
+    for (size_t i = index; remaining > 0; ++i) {
+        if (i >= page.skyline.size()) return -1;
+        y = std::max(y, page.skyline[i].y);
+        if (y + height > m_pageSize) return -1;
+        remaining -= page.skyline[i].width;
+    }
+    return y;
+}
+
+bool TextureAtlas::place(Page& page, int width, int height, int& outX, int& outY) {
+    int bestTop = std::numeric_limits<int>::max();
+    int bestWidth = std::numeric_limits<int>::max();
+    size_t bestIndex = page.skyline.size();
+
+    // Bottom-left rule: lowest resulting top edge, ties broken by the narrower segment
+    for (size_t i = 0; i < page.skyline.size(); ++i) {
+        int y = fit(page, i, width, height);
+        if (y < 0) continue;
+
+        int top = y + height;
+        if (top < bestTop || (top == bestTop && page.skyline[i].width < bestWidth)) {
+            bestTop = top;
+            bestWidth = page.skyline[i].width;
+            bestIndex = i;
+            outX = page.skyline[i].x;
+            outY = y;
+        }
+    }
+
+    if (bestIndex == page.skyline.size()) return false;
+
+    // Raise the skyline over the placed rect and trim the nodes it covers
+    page.skyline.insert(page.skyline.begin() + bestIndex, { outX, outY + height, width });
+
+    for (size_t i = bestIndex + 1; i < page.skyline.size();) {
+        SkylineNode& prev = page.skyline[i - 1];
+        SkylineNode& node = page.skyline[i];
+        int prevRight = prev.x + prev.width;
+        if (node.x >= prevRight) break;
+
+        int shrink = prevRight - node.x;
+        node.x += shrink;
+        node.width -= shrink;
+        if (node.width <= 0) {
+            page.skyline.erase(page.skyline.begin() + i);
+        } else {
+            break;
+        }
+    }
+
+    // Merge neighbours of equal height
+    for (size_t i = 0; i + 1 < page.skyline.size();) {
+        if (page.skyline[i].y == page.skyline[i + 1].y) {
+            page.skyline[i].width += page.skyline[i + 1].width;
+            page.skyline.erase(page.skyline.begin() + i + 1);
+        } else {
+            ++i;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,285 @@
+#include "../../include/includes.h"
+
+TextureLoader::~TextureLoader() {
+    shutdown();
+}
+
+void TextureLoader::initialize(TextureRegistry& registry, unsigned workerCount) {
+    if (!m_workers.empty()) return;
+
+    m_registry = &registry;
+    m_stopping = false;
+
+    if (workerCount == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        workerCount = hardware > 1 ? hardware - 1 : 1;
+    }
+    for (unsigned i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&TextureLoader::workerLoop, this);
+    }
+
+    glGenBuffers(1, &m_pbo);
+}
+
+void TextureLoader::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_decodeQueue.clear();
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+
+    for (auto& result : m_decoded) {
+        stbi_image_free(result.pixels);
+    }
+    m_decoded.clear();
+
+    if (m_uploading) {
+        stbi_image_free(m_upload.image.pixels);
+        if (m_upload.texture) glDeleteTextures(1, &m_upload.texture);
+        m_upload = Upload();
+        m_uploading = false;
+    }
+
+    // Unfinished handles keep their placeholder; callbacks are dropped
+    m_pending.clear();
+
+    if (m_pbo) {
+        glDeleteBuffers(1, &m_pbo);
+        m_pbo = 0;
+    }
+    m_registry = nullptr;
+}
+
+Texture TextureLoader::request(const std::string& path, GLint filtering, Pending*& pending) {
+    pending = nullptr;
+    std::string key = TextureRegistry::fileKey(path, filtering);
+
+    auto it = m_pending.find(key);
+    if (it != m_pending.end()) {
+        pending = &it->second;
+        return Texture(pending->resource);
+    }
+
+    // Already loaded (sync or async), nothing to queue
+    Texture existing = m_registry->find(key);
+    if (existing.getData()) return existing;
+
+    Texture placeholder = m_registry->reserve(key);
+
+    Pending& entry = m_pending[key];
+    entry.resource = placeholder.m_resource;
+    entry.filtering = filtering;
+    pending = &entry;
+
+    m_progress.requested++;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_decodeQueue.push_back({ key, path });
+    }
+    m_wake.notify_one();
+    return placeholder;
+}
+
+Texture TextureLoader::load(const std::string& path, GLint filtering, TextureReadyCallback onReady) {
+    if (!m_registry) {
+        std::cerr << "TextureLoader used before initialize: " << path << std::endl;
+        return Texture(0);
+    }
+
+    Pending* pending = nullptr;
+    Texture texture = request(path, filtering, pending);
+
+    if (onReady) {
+        if (pending) pending->callbacks.push_back(std::move(onReady));
+        else onReady(texture, true);
+    }
+    return texture;
+}
+
+std::shared_future<Texture> TextureLoader::loadFuture(const std::string& path, GLint filtering) {
+    Pending* pending = nullptr;
+    Texture texture = m_registry ? request(path, filtering, pending) : Texture(0);
+
+    if (!pending) {
+        std::promise<Texture> ready;
+        ready.set_value(texture);
+        return ready.get_future().share();
+    }
+    if (!pending->promise) {
+        pending->promise = std::make_shared<std::promise<Texture>>();
+        pending->future = pending->promise->get_future().share();
+    }
+    return pending->future;
+}
+
+void TextureLoader::workerLoop() {
+    // The flip flag is thread local here, so the sync loaders are unaffected
+    stbi_set_flip_vertically_on_load_thread(true);
+
+    while (true) {
+        DecodeJob job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || !m_decodeQueue.empty(); });
+            if (m_stopping) return;
+            job = std::move(m_decodeQueue.front());
+            m_decodeQueue.pop_front();
+        }
+
+        DecodeResult result;
+        result.key = std::move(job.key);
+        int channels;
+        result.pixels = stbi_load(job.path.c_str(), &result.width, &result.height, &channels, STBI_rgb_alpha);
+        if (!result.pixels) {
+            std::cerr << "Failed to load texture: " << job.path << std::endl;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping) {
+                stbi_image_free(result.pixels);
+                return;
+            }
+            m_decoded.push_back(std::move(result));
+        }
+        m_decodedSignal.notify_all();
+    }
+}
+
+bool TextureLoader::beginUpload() {
+    DecodeResult image;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_decoded.empty()) return false;
+        image = std::move(m_decoded.front());
+        m_decoded.pop_front();
+    }
+
+    if (!image.pixels) {
+        complete(image.key, 0);
+        return true;
+    }
+
+    auto it = m_pending.find(image.key);
+    GLint filtering = it != m_pending.end() ? it->second.filtering : GL_LINEAR;
+
+    m_upload = Upload();
+    m_upload.image = image;
+    m_upload.texture = TextureRegistry::upload(image.width, image.height, nullptr, filtering, false);
+    m_uploading = true;
+    return true;
+}
+
+bool TextureLoader::uploadStrip() {
+    const DecodeResult& image = m_upload.image;
+    size_t rowBytes = static_cast<size_t>(image.width) * 4;
+    int rows = static_cast<int>(std::max<size_t>(m_stripBytes / rowBytes, 1));
+    rows = std::min(rows, image.height - m_upload.rowsDone);
+    size_t bytes = rowBytes * rows;
+
+    // Orphan the previous strip so the copy never waits for an in-flight transfer
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    const unsigned char* src = image.pixels + rowBytes * m_upload.rowsDone;
+    if (mapped) {
+        std::memcpy(mapped, src, bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, m_upload.texture);
+    if (mapped) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, m_upload.rowsDone, image.width, rows,
+                        GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    } else {
+        // Mapping failed, fall back to a client-memory copy
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, m_upload.rowsDone, image.width, rows,
+                        GL_RGBA, GL_UNSIGNED_BYTE, src);
+    }
+
+    m_upload.rowsDone += rows;
+    m_progress.bytesUploaded += bytes;
+
+    if (m_upload.rowsDone < image.height) return false;
+
+    // Same result as the synchronous loader: mipmapped with the requested filter
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    GLuint texture = m_upload.texture;
+    std::string key = image.key;
+    stbi_image_free(m_upload.image.pixels);
+    m_upload = Upload();
+    m_uploading = false;
+
+    complete(key, texture);
+    return true;
+}
+
+void TextureLoader::complete(const std::string& key, GLuint texture) {
+    auto it = m_pending.find(key);
+    if (it == m_pending.end()) {
+        if (texture) glDeleteTextures(1, &texture);
+        return;
+    }
+
+    Pending pending = std::move(it->second);
+    m_pending.erase(it);
+
+    bool loaded = texture != 0;
+    if (loaded) {
+        // Every handle shares this resource, so they all switch over at once
+        pending.resource->id = texture;
+        pending.resource->placeholder = false;
+    } else {
+        m_progress.failed++;
+    }
+    m_progress.completed++;
+
+    Texture handle(pending.resource);
+    for (auto& callback : pending.callbacks) {
+        callback(handle, loaded);
+    }
+    if (pending.promise) {
+        pending.promise->set_value(handle);
+    }
+}
+
+int TextureLoader::update(double budgetMs) {
+    if (!m_registry) return 0;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t before = m_progress.completed;
+
+    while (true) {
+        if (!m_uploading && !beginUpload()) break;
+        if (m_uploading) uploadStrip();
+
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() >= budgetMs) break;
+    }
+
+    return static_cast<int>(m_progress.completed - before);
+}
+
+void TextureLoader::finish() {
+    while (busy()) {
+        update(std::numeric_limits<double>::infinity());
+        if (!busy()) break;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_decodedSignal.wait(lock, [this] { return !m_decoded.empty() || m_workers.empty(); });
+        if (m_workers.empty()) break;
+    }
+}
+
+TextureLoadProgress TextureLoader::progress() const {
+    return m_progress;
+}
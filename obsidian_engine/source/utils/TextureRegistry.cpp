@@ -0,0 +1,201 @@
+#include "../../include/includes.h"
+
+static TextureRegistry* activeRegistry = nullptr;
+
+// FNV-1a over the pixel data, used as the content key for fromPixels
+static uint64_t hashPixels(const unsigned char* data, size_t size) {
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+TextureResource::~TextureResource() {
+    if (registry) {
+        std::lock_guard<std::mutex> lock(registry->mutex);
+        auto it = registry->entries.find(key);
+        if (it != registry->entries.end() && it->second.expired()) {
+            registry->entries.erase(it);
+        }
+        // The context is gone once Graphics shut down; nothing left to free
+        if (!registry->contextAlive) return;
+
+        if (id && !placeholder) registry->textures.push_back(id);
+        return;
+    }
+
+    if (id && !placeholder) {
+        glDeleteTextures(1, &id);
+        id = 0;
+    }
+}
+
+TextureRegistry::~TextureRegistry() {
+    shutdown();
+}
+
+TextureRegistry* TextureRegistry::active() {
+    return activeRegistry;
+}
+
+void TextureRegistry::initialize() {
+    if (!m_state) {
+        m_state = std::make_shared<TextureRegistryState>();
+    }
+    m_state->contextAlive = true;
+    activeRegistry = this;
+
+    unsigned char whitePixel[4] = { 255, 255, 255, 255 };
+    m_white = fromPixels(1, 1, whitePixel, GL_NEAREST);
+}
+
+void TextureRegistry::shutdown() {
+    m_white = Texture(0);
+
+    if (m_state) {
+        collect();
+
+        // Handles still held by the application must not touch GL after this point
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->contextAlive = false;
+        m_state.reset();
+    }
+    if (activeRegistry == this) {
+        activeRegistry = nullptr;
+    }
+}
+
+size_t TextureRegistry::collect() {
+    if (!m_state) return 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_released.swap(m_state->textures);
+    }
+
+    size_t count = m_released.size();
+    if (count) glDeleteTextures(static_cast<GLsizei>(count), m_released.data());
+    m_released.clear();
+    return count;
+}
+
+size_t TextureRegistry::liveTextures() const {
+    if (!m_state) return 0;
+
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    size_t count = 0;
+    for (const auto& [key, entry] : m_state->entries) {
+        if (!entry.expired()) count++;
+    }
+    return count;
+}
+
+GLuint TextureRegistry::upload(int width, int height, const unsigned char* rgba, GLint filtering, bool mipmaps) {
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba); // always use RGBA
+
+    if (mipmaps) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filtering);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filtering);
+    return tex;
+}
+
+Texture TextureRegistry::adopt(GLuint id, const std::string& key) {
+    auto resource = std::make_shared<TextureResource>();
+    resource->id = id;
+    resource->key = key;
+
+    if (m_state) {
+        resource->registry = m_state;
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->entries[key] = resource;
+    }
+    return Texture(resource);
+}
+
+std::string TextureRegistry::fileKey(const std::string& path, GLint filtering) {
+    return "file:" + path + "#" + std::to_string(filtering);
+}
+
+Texture TextureRegistry::find(const std::string& key) const {
+    if (m_state) {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        auto it = m_state->entries.find(key);
+        if (it != m_state->entries.end()) {
+            if (auto existing = it->second.lock()) return Texture(existing);
+        }
+    }
+    return Texture(0);
+}
+
+Texture TextureRegistry::reserve(const std::string& key) {
+    Texture handle = adopt(m_white.getData(), key);
+    handle.m_resource->placeholder = true;
+    return handle;
+}
+
+Texture TextureRegistry::load(const std::string& path, GLint filtering) {
+    std::string key = fileKey(path, filtering);
+
+    // May be a placeholder still being filled in by the async loader
+    Texture existing = find(key);
+    if (existing.getData()) return existing;
+
+    Texture loaded = loadUnregistered(path, filtering);
+    if (!loaded.m_resource) return loaded;
+
+    // Hand the freshly uploaded texture over to the registry
+    GLuint id = loaded.m_resource->id;
+    loaded.m_resource->id = 0;
+    return adopt(id, key);
+}
+
+Texture TextureRegistry::loadUnregistered(const std::string& path, GLint filtering) {
+    int w, h, c;
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char* data = stbi_load(path.c_str(), &w, &h, &c, STBI_rgb_alpha); // force 4 channels
+    if (!data) {
+        std::cerr << "Failed to load texture: " << path << std::endl;
+        return Texture(0);
+    }
+
+    auto resource = std::make_shared<TextureResource>();
+    resource->id = upload(w, h, data, filtering, true);
+    resource->key = path;
+
+    stbi_image_free(data);
+    return Texture(resource);
+}
+
+Texture TextureRegistry::create(int width, int height, GLint filtering) {
+    // Contents will change after creation, so the key is unique rather than content based
+    std::string key = "unique:" + std::to_string(m_uniqueCounter++);
+    return adopt(upload(width, height, nullptr, filtering, false), key);
+}
+
+Texture TextureRegistry::fromPixels(int width, int height, const unsigned char* rgba, GLint filtering) {
+    size_t size = static_cast<size_t>(width) * height * 4;
+    std::string key = "pixels:" + std::to_string(hashPixels(rgba, size)) + ":"
+        + std::to_string(width) + "x" + std::to_string(height) + "#" + std::to_string(filtering);
+
+    Texture existing = find(key);
+    if (existing.getData()) {
+        // The hash only narrows the search; a collision must not hand out another image
+        const std::vector<unsigned char>& pixels = existing.m_resource->pixels;
+        if (pixels.size() == size && std::equal(pixels.begin(), pixels.end(), rgba)) return existing;
+        key = "unique:" + std::to_string(m_uniqueCounter++);
+    }
+
+    Texture texture = adopt(upload(width, height, rgba, filtering, false), key);
+    texture.m_resource->pixels.assign(rgba, rgba + size);
+    return texture;
+}